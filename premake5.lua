@@ -1,3 +1,8 @@
+newoption {
+	trigger = "fast-noise",
+	description = "Let FastNoiseSIMD use FMA and reciprocal estimates, the noise then differs slightly between SIMD levels",
+}
+
 solution "surface"
 	platforms { "Win64" }
 	configurations { "Debug", "Release", "Retail" }
@@ -113,6 +118,9 @@ project "surface"
 	filter "files:FastNoiseSIMD_avx2.cpp"
 		buildoptions { "/arch:AVX" }
 
+	filter "options:fast-noise"
+		defines { "FN_NONDETERMINISTIC" }
+
 	filter "configurations:Debug"
 		defines { 
 			"_DEBUG",
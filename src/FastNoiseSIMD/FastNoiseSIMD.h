@@ -31,6 +31,15 @@
 #ifndef FASTNOISE_SIMD_H
 #define FASTNOISE_SIMD_H
 
+// Deterministic mode gives bit-identical noise output on every SIMD level (and the fallback), so generated
+// sets can be cached and shared between machines. Disables FMA and swaps reciprocal (square root) estimates
+// for exact division. GCC/Clang need -ffp-contract=off as well so they don't contract multiply-adds themselves
+// ARMv7 NEON has no exact division or square root, only AArch64 is deterministic on ARM
+// On by default, define FN_NONDETERMINISTIC to turn it off (premake --fast-noise)
+#if !defined(FN_DETERMINISTIC) && !defined(FN_NONDETERMINISTIC)
+#define FN_DETERMINISTIC
+#endif
+
 #if defined(__arm__) || defined(__aarch64__)
 #define FN_ARM
 //#define FN_IOS
@@ -51,8 +60,10 @@
 // Using FMA instructions with AVX(51)2/NEON provides a small performance increase but can cause 
 // minute variations in noise output compared to other SIMD levels due to higher calculation precision
 // Intel compiler will always generate FMA instructions, use /Qfma- or -no-fma to disable
+#ifndef FN_DETERMINISTIC
 #define FN_USE_FMA
 #endif
+#endif
 
 // Using aligned sets of memory for float arrays allows faster storing of SIMD data
 // Comment out to allow unaligned float arrays to be used as sets
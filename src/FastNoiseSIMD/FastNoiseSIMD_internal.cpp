@@ -163,6 +163,9 @@ static SIMDf SIMDf_NUM(1);
 #define SIMDf_ADD(a,b) vaddq_f32(a,b)
 #define SIMDf_SUB(a,b) vsubq_f32(a,b)
 #define SIMDf_MUL(a,b) vmulq_f32(a,b)
+#if defined(FN_DETERMINISTIC) && defined(__aarch64__)
+#define SIMDf_DIV(a,b) vdivq_f32(a,b)
+#else
 #define SIMDf_DIV(a,b) FUNC(DIV)(a,b)
 
 static SIMDf VECTORCALL FUNC(DIV)(SIMDf a, SIMDf b)
@@ -176,10 +179,15 @@ static SIMDf VECTORCALL FUNC(DIV)(SIMDf a, SIMDf b)
 	// and finally, compute a/b = a*(1/b)
 	return vmulq_f32(a, reciprocal);
 }
+#endif
 
 #define SIMDf_MIN(a,b) vminq_f32(a,b)
 #define SIMDf_MAX(a,b) vmaxq_f32(a,b)
+#if defined(FN_DETERMINISTIC) && defined(__aarch64__)
+#define SIMDf_INV_SQRT(a) vdivq_f32(SIMDf_NUM(1), vsqrtq_f32(a))
+#else
 #define SIMDf_INV_SQRT(a) vrsqrteq_f32(a)
+#endif
 
 #define SIMDf_LESS_THAN(a,b) vreinterpretq_s32_u32(vcltq_f32(a,b))
 #define SIMDf_GREATER_THAN(a,b) vreinterpretq_s32_u32(vcgtq_f32(a,b))
@@ -246,7 +254,11 @@ static SIMDf VECTORCALL FUNC(FLOOR)(SIMDf a)
 
 #define SIMDf_MIN(a,b) _mm512_min_ps(a,b)
 #define SIMDf_MAX(a,b) _mm512_max_ps(a,b)
+#ifdef FN_DETERMINISTIC
+#define SIMDf_INV_SQRT(a) _mm512_div_ps(SIMDf_NUM(1), _mm512_sqrt_ps(a))
+#else
 #define SIMDf_INV_SQRT(a) _mm512_rsqrt14_ps(a)
+#endif
 
 #define SIMDf_LESS_THAN(a,b) _mm512_cmp_ps_mask(a,b,_CMP_LT_OQ)
 #define SIMDf_GREATER_THAN(a,b) _mm512_cmp_ps_mask(a,b,_CMP_GT_OQ)
@@ -313,7 +325,11 @@ static SIMDf VECTORCALL FUNC(FLOOR)(SIMDf a)
 
 #define SIMDf_MIN(a,b) _mm256_min_ps(a,b)
 #define SIMDf_MAX(a,b) _mm256_max_ps(a,b)
+#ifdef FN_DETERMINISTIC
+#define SIMDf_INV_SQRT(a) _mm256_div_ps(SIMDf_NUM(1), _mm256_sqrt_ps(a))
+#else
 #define SIMDf_INV_SQRT(a) _mm256_rsqrt_ps(a)
+#endif
 
 #define SIMDf_LESS_THAN(a,b) SIMDi_CAST_TO_INT(_mm256_cmp_ps(a,b,_CMP_LT_OQ))
 #define SIMDf_GREATER_THAN(a,b) SIMDi_CAST_TO_INT(_mm256_cmp_ps(a,b,_CMP_GT_OQ))
@@ -371,7 +387,11 @@ static SIMDf VECTORCALL FUNC(FLOOR)(SIMDf a)
 
 #define SIMDf_MIN(a,b) _mm_min_ps(a,b)
 #define SIMDf_MAX(a,b) _mm_max_ps(a,b)
+#ifdef FN_DETERMINISTIC
+#define SIMDf_INV_SQRT(a) _mm_div_ps(SIMDf_NUM(1), _mm_sqrt_ps(a))
+#else
 #define SIMDf_INV_SQRT(a) _mm_rsqrt_ps(a)
+#endif
 
 #define SIMDf_LESS_THAN(a,b) SIMDi_CAST_TO_INT(_mm_cmplt_ps(a,b))
 #define SIMDf_GREATER_THAN(a,b) SIMDi_CAST_TO_INT(_mm_cmpgt_ps(a,b))
@@ -442,6 +462,13 @@ static float FUNC(CAST_TO_FLOAT)(int i) { return *reinterpret_cast<float*>(&i);
 #define SIMDf_MUL(a,b) ((a) * (b))
 #define SIMDf_DIV(a,b) ((a) / (b))
 
+#ifdef FN_DETERMINISTIC
+// Same operand order as minps/maxps, fminf/fmaxf treat signed zeros and NaNs differently
+#define SIMDf_MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define SIMDf_MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+#define SIMDf_INV_SQRT(a) (1.0f / sqrtf(a))
+#else
 #define SIMDf_MIN(a,b) fminf(a,b)
 #define SIMDf_MAX(a,b) fmaxf(a,b)
 
@@ -455,6 +482,7 @@ static float FUNC(INV_SQRT)(float x)
 	return x;
 }
 #define SIMDf_INV_SQRT(a) FUNC(INV_SQRT)(a)
+#endif
 
 #define SIMDf_LESS_THAN(a,b) (((a) < (b)) ? 0xFFFFFFFF : 0)
 #define SIMDf_GREATER_THAN(a,b) (((a) > (b)) ? 0xFFFFFFFF : 0)
@@ -487,7 +515,12 @@ static float FUNC(INV_SQRT)(float x)
 #define SIMDi_GREATER_THAN(a,b) (((a) > (b)) ? 0xFFFFFFFF : 0)
 #define SIMDi_LESS_THAN(a,b) (((a) < (b)) ? 0xFFFFFFFF : 0)
 
+#ifdef FN_DETERMINISTIC
+// cvtps2dq rounds half to even, roundf rounds half away from zero
+#define SIMDi_CONVERT_TO_INT(a) static_cast<int>(nearbyintf(a))
+#else
 #define SIMDi_CONVERT_TO_INT(a) static_cast<int>(roundf(a))
+#endif
 #define SIMDf_CONVERT_TO_FLOAT(a) static_cast<float>(a)
 #endif
 
@@ -2153,9 +2186,10 @@ void SIMD_LEVEL_CLASS::FillSampledNoiseSet(float* noiseSet, int xStart, int ySta
 	int sampleMask = sampleSize - 1;
 	float scaleModifier = float(sampleSize);
 
-	int xOffset = (sampleSize - (xStart & sampleMask)) & sampleMask;
-	int yOffset = (sampleSize - (yStart & sampleMask)) & sampleMask;
-	int zOffset = (sampleSize - (zStart & sampleMask)) & sampleMask;
+	// Distance from the coarse lattice point at or below the start, so neighbouring sets share lattice points.
+	int xOffset = xStart & sampleMask;
+	int yOffset = yStart & sampleMask;
+	int zOffset = zStart & sampleMask;
 
 	int xSizeSample = xSize + xOffset;
 	int ySizeSample = ySize + yOffset;
@@ -2182,7 +2216,8 @@ void SIMD_LEVEL_CLASS::FillSampledNoiseSet(float* noiseSet, int xStart, int ySta
 
 	SIMDi axisMask = SIMDi_SET(sampleMask);
 	SIMDf axisScale = SIMDf_SET(1.f / scaleModifier);
-	SIMDf axisOffset = SIMDf_MUL(axisScale, SIMDf_NUM(0_5));
+	// Lattice points land on samples, interpolation weights start at 0.
+	SIMDf axisOffset = SIMDf_SET_ZERO();
 
 	SIMDi sampleSizeSIMD = SIMDi_SET(sampleSize);
 	SIMDi xSIMD = SIMDi_SET(-xOffset);
@@ -8,6 +8,7 @@
 #include <glm/ext/matrix_clip_space.hpp>
 
 #include <algorithm>
+#include <cmath>
 
 using namespace DirectX;
 
@@ -16,11 +17,14 @@ constexpr float LookSensitivity = 5.0f;
 
 Camera::Camera()
 	: m_position(0.0f, 0.0f, 0.0f)
+	, m_velocity(0.0f, 0.0f, 0.0f)
+	, m_forward(0.0f, 0.0f, -1.0f)
 	, m_yaw(0.0f)
 	, m_pitch(0.0f)
 	, m_fovInDegrees(75.0f)
 	, m_nearClip(0.1f)
 	, m_farClip(128.0f)
+	, m_projectionScale(1.0f)
 	, m_worldMatrix(1.0f)
 	, m_worldToViewMatrix(1.0f)
 	, m_viewToNDCMatrix(1.0f)
@@ -103,8 +107,12 @@ void Camera::update(Input& input, float deltaTime)
 	cameraRot = glm::rotate(cameraRot, m_yaw, glm::vec3(0.0f, 1.0f, 0.0f));
 	cameraRot = glm::rotate(cameraRot, m_pitch, glm::vec3(1.0f, 0.0f, 0.0f));
 
-	m_position += glm::vec3(cameraRot[0]) * input_move_right * adjustedMovementSpeed * deltaTime;
-	m_position += glm::vec3(cameraRot[2]) * -input_move_forward * adjustedMovementSpeed * deltaTime;
+	m_forward = -glm::vec3(cameraRot[2]);
+
+	m_velocity = glm::vec3(cameraRot[0]) * input_move_right * adjustedMovementSpeed;
+	m_velocity += m_forward * input_move_forward * adjustedMovementSpeed;
+
+	m_position += m_velocity * deltaTime;
 
 	const float fovInRadians = glm::radians(m_fovInDegrees);
 
@@ -121,4 +129,6 @@ void Camera::update(Input& input, float deltaTime)
 		m_nearClip,
 		m_farClip);
 	m_worldToNDCMatrix = m_viewToNDCMatrix * m_worldToViewMatrix;
+
+	m_projectionScale = (float)screenHeight / (2.0f * std::tan(fovInRadians * 0.5f));
 }
@@ -18,8 +18,14 @@ public:
 	inline const glm::mat4& getWorldToNDCMatrix() const { return m_worldToNDCMatrix; }
 
 	inline const glm::vec3& getPosition() const { return m_position; }
+	inline const glm::vec3& getVelocity() const { return m_velocity; }
+	inline const glm::vec3& getForward() const { return m_forward; }
 
 	inline const float getFarClip() const { return m_farClip; }
+	inline void setFarClip(float farClip) { m_farClip = farClip; }
+
+	// Pixels covered by one unit facing the camera one unit away, screen space sizes are this over distance.
+	inline float getProjectionScale() const { return m_projectionScale; }
 
 private:
 	glm::mat4 m_worldMatrix;
@@ -28,9 +34,12 @@ private:
 	glm::mat4 m_worldToNDCMatrix;
 
 	glm::vec3 m_position;
+	glm::vec3 m_velocity;
+	glm::vec3 m_forward;
 	float m_yaw;
 	float m_pitch;
 	float m_fovInDegrees;
 	float m_nearClip;
 	float m_farClip;
+	float m_projectionScale;
 };
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "chunk_benchmark.hpp"
+#include "chunk_generation.hpp"
+#include "terrain.hpp"
+#include "jobs.hpp"
+#include "topology.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+constexpr int BenchmarkSeed = 1337;
+constexpr int32_t BenchmarkSideChunks = 16;
+constexpr int32_t BenchmarkMinChunkY = -2;
+constexpr int32_t BenchmarkMaxChunkY = 2;
+constexpr int BenchmarkRunCount = 3;
+
+struct BenchmarkPolicy
+{
+	const char* name;
+	topology::WorkerPlacement placement;
+};
+
+static double generateChunks(const std::vector<glm::i32vec3>& positions)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	jobs::parallelFor(positions.size(), 1, [&positions](size_t i) {
+		std::unique_ptr<float[]> terrainSamples = sampleChunk(0, positions[i]);
+		if (!hasSurfaceCrossing(terrainSamples.get()))
+		{
+			return;
+		}
+
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> normals;
+		triangulateChunk(0, positions[i], terrainSamples.get(), vertices, normals);
+
+		size_t vertexCount;
+		glm::vec3* positionBuffer;
+		glm::vec3* normalBuffer;
+		packChunkBuffers(vertices, normals, &positionBuffer, &normalBuffer, &vertexCount);
+
+		delete[] positionBuffer;
+		delete[] normalBuffer;
+	});
+
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	return elapsed.count();
+}
+
+void runChunkBenchmark()
+{
+	Terrain::init(BenchmarkSeed);
+
+	const topology::Topology& topology = topology::get();
+	printf("%zu cores, %u logical processors, %u core classes\n", 
+		topology.cores.size(), 
+		topology.processorCount, 
+		topology.coreClassCount);
+
+	std::vector<glm::i32vec3> positions;
+	for (int32_t z = 0; z < BenchmarkSideChunks; ++z)
+	{
+		for (int32_t y = BenchmarkMinChunkY; y < BenchmarkMaxChunkY; ++y)
+		{
+			for (int32_t x = 0; x < BenchmarkSideChunks; ++x)
+			{
+				positions.push_back(glm::i32vec3(x, y, z));
+			}
+		}
+	}
+
+	std::vector<BenchmarkPolicy> policies;
+	{
+		BenchmarkPolicy policy{ "floating, physical cores", {} };
+		policies.push_back(policy);
+
+		policy.name = "floating, all threads";
+		policy.placement.smtPolicy = topology::SmtPolicy::AllThreads;
+		policies.push_back(policy);
+
+		policy.name = "pinned, all threads";
+		policy.placement.pinWorkers = true;
+		policies.push_back(policy);
+
+		policy.name = "pinned, physical cores";
+		policy.placement.smtPolicy = topology::SmtPolicy::PhysicalCores;
+		policies.push_back(policy);
+
+		policy.name = "pinned, physical cores, main core shared";
+		policy.placement.reserveMainCore = false;
+		policies.push_back(policy);
+
+		policy.name = "pinned, physical cores, normal priority";
+		policy.placement.reserveMainCore = true;
+		policy.placement.backgroundPriority = false;
+		policies.push_back(policy);
+
+		if (topology.coreClassCount > 1)
+		{
+			policy.name = "pinned, physical cores, fastest class only";
+			policy.placement.backgroundPriority = true;
+			for (uint32_t coreClass = 0; coreClass + 1 < topology.coreClassCount; ++coreClass)
+			{
+				policy.placement.maxWorkersPerCoreClass[coreClass] = 0;
+			}
+			policies.push_back(policy);
+		}
+	}
+
+	for (const BenchmarkPolicy& policy : policies)
+	{
+		jobs::init(policy.placement);
+
+		// The first run pays for page faults and cold caches.
+		generateChunks(positions);
+
+		double bestTime = 1e9;
+		for (int run = 0; run < BenchmarkRunCount; ++run)
+		{
+			const double time = generateChunks(positions);
+			bestTime = time < bestTime ? time : bestTime;
+		}
+
+		printf("%-44s %2zu workers %8.1f ms %8.1f chunks/s\n", 
+			policy.name, 
+			jobs::workerCount(), 
+			bestTime * 1000.0, 
+			(double)positions.size() / bestTime);
+
+		jobs::shutdown();
+	}
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Generates a fixed block of chunks on the CPU under each worker placement policy and prints the
+// throughput of each, no window or GPU needed. Run with -chunkbench.
+void runChunkBenchmark();
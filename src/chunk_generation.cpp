@@ -0,0 +1,789 @@
+#include "chunk_generation.hpp"
+#include "terrain.hpp"
+
+#include <tracy/Tracy.hpp>
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/*
+Linearly interpolate the position where an isosurface cuts
+an edge between two vertices, each with their own scalar value
+*/
+static glm::vec3 vertexInterp(
+	float isolevel, 
+	glm::vec3 p1,
+	glm::vec3 p2,
+	float valp1, 
+	float valp2)
+{
+	if (abs(isolevel - valp1) < 0.00001f)
+		return(p1);
+	if (abs(isolevel - valp2) < 0.00001f)
+		return(p2);
+	if (abs(valp1 - valp2) < 0.00001f)
+		return(p1);
+
+	float mu = (isolevel - valp1) / (valp2 - valp1);
+
+	glm::vec3 p;
+	p.x = p1.x + mu * (p2.x - p1.x);
+	p.y = p1.y + mu * (p2.y - p1.y);
+	p.z = p1.z + mu * (p2.z - p1.z);
+	return(p);
+}
+
+struct GridCell
+{
+	glm::vec3 p[8];
+	float val[8];
+};
+
+/*
+Given a grid cell and an isolevel, calculate the triangular
+facets required to represent the isosurface through the cell.
+Return the number of triangular facets, the array "triangles"
+will be loaded up with the vertices at most 5 triangular facets.
+0 will be returned if the grid cell is either totally above
+of totally below the isolevel.
+*/
+static void polygonise(
+	GridCell grid, 
+	float isolevel, 
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec3>& normals)
+{
+	constexpr int edgeTable[256] = {
+		0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
+		0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+		0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
+		0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+		0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
+		0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+		0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
+		0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+		0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
+		0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+		0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
+		0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+		0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
+		0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+		0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
+		0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+		0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
+		0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+		0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
+		0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+		0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
+		0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+		0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
+		0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
+		0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
+		0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
+		0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
+		0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
+		0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
+		0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
+		0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
+		0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0 
+	};
+
+	constexpr int triTable[256][16] =
+	{ 
+		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
+		{ 8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1 },
+		{ 3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1 },
+		{ 4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
+		{ 4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1 },
+		{ 9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1 },
+		{ 10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1 },
+		{ 5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
+		{ 5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1 },
+		{ 8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1 },
+		{ 2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
+		{ 2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1 },
+		{ 11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1 },
+		{ 5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1 },
+		{ 11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1 },
+		{ 11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1 },
+		{ 2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1 },
+		{ 6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
+		{ 3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1 },
+		{ 6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
+		{ 6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1 },
+		{ 8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1 },
+		{ 7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1 },
+		{ 3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
+		{ 0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1 },
+		{ 9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1 },
+		{ 8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
+		{ 5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1 },
+		{ 0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1 },
+		{ 6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1 },
+		{ 10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
+		{ 1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1 },
+		{ 0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1 },
+		{ 3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
+		{ 6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1 },
+		{ 9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1 },
+		{ 8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1 },
+		{ 3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1 },
+		{ 10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1 },
+		{ 10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
+		{ 2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1 },
+		{ 7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
+		{ 2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1 },
+		{ 1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1 },
+		{ 11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1 },
+		{ 8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1 },
+		{ 0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1 },
+		{ 7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1 },
+		{ 7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1 },
+		{ 10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1 },
+		{ 7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1 },
+		{ 6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1 },
+		{ 4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1 },
+		{ 10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1 },
+		{ 8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1 },
+		{ 1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1 },
+		{ 10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1 },
+		{ 10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1 },
+		{ 9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1 },
+		{ 7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1 },
+		{ 3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1 },
+		{ 7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1 },
+		{ 3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1 },
+		{ 6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1 },
+		{ 9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1 },
+		{ 1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1 },
+		{ 4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1 },
+		{ 7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1 },
+		{ 6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1 },
+		{ 0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1 },
+		{ 6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1 },
+		{ 0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1 },
+		{ 11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1 },
+		{ 6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1 },
+		{ 5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1 },
+		{ 9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1 },
+		{ 1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1 },
+		{ 10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1 },
+		{ 0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1 },
+		{ 11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1 },
+		{ 9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1 },
+		{ 7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1 },
+		{ 2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1 },
+		{ 9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1 },
+		{ 9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1 },
+		{ 1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1 },
+		{ 0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1 },
+		{ 10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1 },
+		{ 2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1 },
+		{ 0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1 },
+		{ 0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1 },
+		{ 9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1 },
+		{ 5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1 },
+		{ 5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1 },
+		{ 8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1 },
+		{ 9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1 },
+		{ 1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1 },
+		{ 3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1 },
+		{ 4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1 },
+		{ 9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1 },
+		{ 11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1 },
+		{ 2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1 },
+		{ 9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1 },
+		{ 3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1 },
+		{ 1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1 },
+		{ 4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1 },
+		{ 0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1 },
+		{ 1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 } 
+	};
+
+	/*
+	Determine the index into the edge table which
+	tells us which vertices are inside of the surface
+	*/
+	int cubeindex = 0;
+	if (grid.val[0] < isolevel) cubeindex |= 1;
+	if (grid.val[1] < isolevel) cubeindex |= 2;
+	if (grid.val[2] < isolevel) cubeindex |= 4;
+	if (grid.val[3] < isolevel) cubeindex |= 8;
+	if (grid.val[4] < isolevel) cubeindex |= 16;
+	if (grid.val[5] < isolevel) cubeindex |= 32;
+	if (grid.val[6] < isolevel) cubeindex |= 64;
+	if (grid.val[7] < isolevel) cubeindex |= 128;
+
+	/* Cube is entirely in/out of the surface */
+	if (edgeTable[cubeindex] == 0)
+		return;
+
+	/* Find the vertices where the surface intersects the cube */
+	glm::vec3 vertlist[12];
+	if (edgeTable[cubeindex] & 1)
+		vertlist[0] = vertexInterp(isolevel, grid.p[0], grid.p[1], grid.val[0], grid.val[1]);
+	if (edgeTable[cubeindex] & 2)
+		vertlist[1] = vertexInterp(isolevel, grid.p[1], grid.p[2], grid.val[1], grid.val[2]);
+	if (edgeTable[cubeindex] & 4)
+		vertlist[2] = vertexInterp(isolevel, grid.p[2], grid.p[3], grid.val[2], grid.val[3]);
+	if (edgeTable[cubeindex] & 8)
+		vertlist[3] = vertexInterp(isolevel, grid.p[3], grid.p[0], grid.val[3], grid.val[0]);
+	if (edgeTable[cubeindex] & 16)
+		vertlist[4] = vertexInterp(isolevel, grid.p[4], grid.p[5], grid.val[4], grid.val[5]);
+	if (edgeTable[cubeindex] & 32)
+		vertlist[5] = vertexInterp(isolevel, grid.p[5], grid.p[6], grid.val[5], grid.val[6]);
+	if (edgeTable[cubeindex] & 64)
+		vertlist[6] = vertexInterp(isolevel, grid.p[6], grid.p[7], grid.val[6], grid.val[7]);
+	if (edgeTable[cubeindex] & 128)
+		vertlist[7] = vertexInterp(isolevel, grid.p[7], grid.p[4], grid.val[7], grid.val[4]);
+	if (edgeTable[cubeindex] & 256)
+		vertlist[8] = vertexInterp(isolevel, grid.p[0], grid.p[4], grid.val[0], grid.val[4]);
+	if (edgeTable[cubeindex] & 512)
+		vertlist[9] = vertexInterp(isolevel, grid.p[1], grid.p[5], grid.val[1], grid.val[5]);
+	if (edgeTable[cubeindex] & 1024)
+		vertlist[10] = vertexInterp(isolevel, grid.p[2], grid.p[6], grid.val[2], grid.val[6]);
+	if (edgeTable[cubeindex] & 2048)
+		vertlist[11] = vertexInterp(isolevel, grid.p[3], grid.p[7], grid.val[3], grid.val[7]);
+
+	/* Create the triangle */
+	for (int i = 0; triTable[cubeindex][i] != -1; i += 3)
+	{
+		const glm::vec3& v0 = vertlist[triTable[cubeindex][i]];
+		const glm::vec3& v1 = vertlist[triTable[cubeindex][i + 1]];
+		const glm::vec3& v2 = vertlist[triTable[cubeindex][i + 2]];
+
+		glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
+
+		vertices.push_back(v0);
+		vertices.push_back(v1);
+		vertices.push_back(v2);
+
+		normals.push_back(normal);
+		normals.push_back(normal);
+		normals.push_back(normal);
+	}
+}
+
+// Skirts close the cracks where a chunk meets a neighbour of another LOD level. Both sample the shared 
+// face at their own spacing, so their surfaces cut it along different contours. Each chunk fills the 
+// solid part of its faces in a band around its own contour, facing out of the chunk, which covers the 
+// gap from whichever side is solid there. Between chunks of the same level the fills coincide inside 
+// the solid. ChunkLodSelector doesn't limit neighbours to one level apart, two cells of band still cover 
+// the contours of neighbours a level or two coarser.
+constexpr int32_t SkirtBandCells = 2;
+constexpr uint32_t ChunkFaceCount = 6;
+constexpr uint32_t ChunkFaceCellCount = ChunkSideSize * ChunkSideSize;
+
+// Face f lies on the axis f / 2 plane, at the chunk's low side if f is even and its high side if odd. 
+// Cells on a face are indexed (u, v) with u along the next axis and v along the one after.
+struct ChunkFaceBands
+{
+	bool inBand[ChunkFaceCount][ChunkFaceCellCount];
+};
+
+static uint32_t getFaceSampleIndex(uint32_t face, uint32_t u, uint32_t v)
+{
+	const uint32_t sampleGridSideSize = ChunkSideSize + 1;
+	const uint32_t axis = face / 2;
+
+	uint32_t coords[3];
+	coords[axis] = (face & 1) ? ChunkSideSize : 0;
+	coords[(axis + 1) % 3] = u;
+	coords[(axis + 2) % 3] = v;
+
+	return (coords[2] * sampleGridSideSize * sampleGridSideSize) + (coords[1] * sampleGridSideSize) + coords[0];
+}
+
+static void findSkirtBands(
+	const float* terrainSamples,
+	ChunkFaceBands& bands)
+{
+	const int32_t side = (int32_t)ChunkSideSize;
+
+	bool crossing[ChunkFaceCellCount];
+	bool rowBand[ChunkFaceCellCount];
+
+	for (uint32_t face = 0; face < ChunkFaceCount; ++face)
+	{
+		for (uint32_t v = 0; v < ChunkSideSize; ++v)
+		{
+			for (uint32_t u = 0; u < ChunkSideSize; ++u)
+			{
+				const bool inside = terrainSamples[getFaceSampleIndex(face, u, v)] < 0.0f;
+				crossing[v * ChunkSideSize + u] = 
+					(terrainSamples[getFaceSampleIndex(face, u + 1, v)] < 0.0f) != inside ||
+					(terrainSamples[getFaceSampleIndex(face, u + 1, v + 1)] < 0.0f) != inside ||
+					(terrainSamples[getFaceSampleIndex(face, u, v + 1)] < 0.0f) != inside;
+			}
+		}
+
+		// Square dilation of the cells the contour passes through, along u and then along v.
+		for (int32_t v = 0; v < side; ++v)
+		{
+			for (int32_t u = 0; u < side; ++u)
+			{
+				bool isInBand = false;
+				for (int32_t du = std::max(u - SkirtBandCells, 0); du <= std::min(u + SkirtBandCells, side - 1); ++du)
+				{
+					isInBand |= crossing[v * side + du];
+				}
+				rowBand[v * side + u] = isInBand;
+			}
+		}
+
+		for (int32_t v = 0; v < side; ++v)
+		{
+			for (int32_t u = 0; u < side; ++u)
+			{
+				bool isInBand = false;
+				for (int32_t dv = std::max(v - SkirtBandCells, 0); dv <= std::min(v + SkirtBandCells, side - 1); ++dv)
+				{
+					isInBand |= rowBand[dv * side + u];
+				}
+				bands.inBand[face][v * side + u] = isInBand;
+			}
+		}
+	}
+}
+
+// Fills the solid part of one face cell, wound to face out of the chunk.
+static void addSkirtCell(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	const float* terrainSamples,
+	uint32_t face,
+	uint32_t u,
+	uint32_t v,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec3>& normals)
+{
+	const float sizeMultiplier = (float)(1 << lodLevel);
+	const int32_t nodeSize = (int32_t)(ChunkSideSize << lodLevel);
+	const uint32_t axis = face / 2;
+
+	// Counterclockwise around the u x v axis, which is the face axis.
+	const uint32_t cornerU[4] = { u, u + 1, u + 1, u };
+	const uint32_t cornerV[4] = { v, v, v + 1, v + 1 };
+
+	glm::vec3 points[4];
+	float values[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		uint32_t coords[3];
+		coords[axis] = (face & 1) ? ChunkSideSize : 0;
+		coords[(axis + 1) % 3] = cornerU[i];
+		coords[(axis + 2) % 3] = cornerV[i];
+
+		points[i] = glm::vec3(
+			(float)(origin.x * nodeSize) + coords[0] * sizeMultiplier,
+			(float)(origin.y * nodeSize) + coords[1] * sizeMultiplier,
+			(float)(origin.z * nodeSize) + coords[2] * sizeMultiplier);
+		values[i] = terrainSamples[getFaceSampleIndex(face, cornerU[i], cornerV[i])];
+	}
+
+	// Corners and edge crossings of the solid side in order, at most a hexagon. Samples are positive 
+	// inside the terrain, the surface's normals point to the negative side.
+	glm::vec3 polygon[8];
+	int polygonSize = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		const int next = (i + 1) & 3;
+		const bool isSolid = values[i] >= 0.0f;
+
+		if (isSolid)
+		{
+			polygon[polygonSize++] = points[i];
+		}
+
+		if (isSolid != (values[next] >= 0.0f))
+		{
+			// Low to high corner like neighbouring cells, so shared crossings match exactly.
+			polygon[polygonSize++] = i < 2 
+				? vertexInterp(0.0f, points[i], points[next], values[i], values[next]) 
+				: vertexInterp(0.0f, points[next], points[i], values[next], values[i]);
+		}
+	}
+
+	if (polygonSize < 3)
+	{
+		return;
+	}
+
+	glm::vec3 normal(0.0f);
+	normal[axis] = (face & 1) ? 1.0f : -1.0f;
+
+	const bool flip = (face & 1) == 0;
+	for (int i = 1; i + 1 < polygonSize; ++i)
+	{
+		vertices.push_back(polygon[0]);
+		vertices.push_back(polygon[flip ? i + 1 : i]);
+		vertices.push_back(polygon[flip ? i : i + 1]);
+
+		normals.push_back(normal);
+		normals.push_back(normal);
+		normals.push_back(normal);
+	}
+}
+
+// Skirts of the face cells in one z plane of cells, the z faces go with the first and last plane.
+static void addPlaneSkirts(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	const float* terrainSamples,
+	const ChunkFaceBands& bands,
+	uint32_t plane,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec3>& normals)
+{
+	for (uint32_t face = 0; face < ChunkFaceCount; ++face)
+	{
+		const uint32_t axis = face / 2;
+
+		if (axis == 2)
+		{
+			if (plane != ((face & 1) ? ChunkSideSize - 1 : 0))
+			{
+				continue;
+			}
+
+			for (uint32_t i = 0; i < ChunkFaceCellCount; ++i)
+			{
+				if (bands.inBand[face][i])
+				{
+					addSkirtCell(lodLevel, origin, terrainSamples, face, i % ChunkSideSize, i / ChunkSideSize, vertices, normals);
+				}
+			}
+			continue;
+		}
+
+		// z is v on x faces and u on y faces.
+		for (uint32_t i = 0; i < ChunkSideSize; ++i)
+		{
+			const uint32_t u = axis == 0 ? i : plane;
+			const uint32_t v = axis == 0 ? plane : i;
+			if (bands.inBand[face][v * ChunkSideSize + u])
+			{
+				addSkirtCell(lodLevel, origin, terrainSamples, face, u, v, vertices, normals);
+			}
+		}
+	}
+}
+
+std::unique_ptr<float[]> sampleChunk(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin)
+{
+	const uint32_t sampleGridSideSize = ChunkSideSize + 1;
+	const uint32_t sampleCount = sampleGridSideSize * sampleGridSideSize * sampleGridSideSize;
+
+	// TODO: consider using bitmask if we want to skip the intersection point approximation in the triangulation
+	std::unique_ptr<float[]> terrainSamples(new float[sampleCount]);
+
+	sampleChunkSlab(lodLevel, origin, 0, sampleGridSideSize, terrainSamples.get());
+
+	return terrainSamples;
+}
+
+void sampleChunkSlab(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	uint32_t firstPlane,
+	uint32_t planeCount,
+	float* terrainSamples)
+{
+	ZoneScopedN("Sample Terrain");
+
+	const float sizeMultiplier = (float)(1 << lodLevel);
+
+	const uint32_t sampleGridSideSize = ChunkSideSize + 1;
+	const uint32_t planeSampleCount = sampleGridSideSize * sampleGridSideSize;
+
+	// Terrain samples with x and z swapped, z planes are the outermost and slabs are contiguous. The 
+	// origin is in samples, which the scale spreads out to the node's size.
+	const int32_t x = origin.z * (int32_t)ChunkSideSize + (int32_t)firstPlane;
+	const int32_t y = origin.y * (int32_t)ChunkSideSize;
+	const int32_t z = origin.x * (int32_t)ChunkSideSize;
+
+	Terrain::sample(terrainSamples + (firstPlane * planeSampleCount), x, y, z, planeCount, sampleGridSideSize, sampleGridSideSize, sizeMultiplier);
+}
+
+bool hasSurfaceCrossing(
+	const float* terrainSamples)
+{
+	ZoneScoped;
+
+	const uint32_t sampleGridSideSize = ChunkSideSize + 1;
+	const uint32_t sampleCount = sampleGridSideSize * sampleGridSideSize * sampleGridSideSize;
+
+	// Same test as the cube index in polygonise, no cell gets triangles unless both sides show up.
+	const bool firstIsInside = terrainSamples[0] < 0.0f;
+	for (uint32_t i = 1; i < sampleCount; ++i)
+	{
+		if ((terrainSamples[i] < 0.0f) != firstIsInside)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void triangulateChunk(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	const float* terrainSamples,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec3>& normals)
+{
+	triangulateChunkSlab(lodLevel, origin, terrainSamples, 0, ChunkSideSize, vertices, normals);
+}
+
+void triangulateChunkSlab(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	const float* terrainSamples,
+	uint32_t firstPlane,
+	uint32_t planeCount,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec3>& normals)
+{
+	ZoneScopedN("Triangulate");
+
+	const uint32_t lodPlaneBlockCount = ChunkSideSize * ChunkSideSize;
+	const uint32_t lodBlockCount = lodPlaneBlockCount * planeCount;
+	const float sizeMultiplier = (float)(1 << lodLevel);
+	const int32_t nodeSize = (int32_t)(ChunkSideSize << lodLevel);
+
+	const uint32_t sampleGridSideSize = ChunkSideSize + 1;
+
+	vertices.reserve(lodBlockCount * 3);
+	normals.reserve(lodBlockCount * 3);
+
+	const uint32_t terrainSampleOffsetX = 1;
+	const uint32_t terrainSampleOffsetY = sampleGridSideSize;
+	const uint32_t terrainSampleOffsetZ = sampleGridSideSize * sampleGridSideSize;
+
+	ChunkFaceBands bands;
+	findSkirtBands(terrainSamples, bands);
+
+	const uint32_t firstBlock = firstPlane * lodPlaneBlockCount;
+	for (uint32_t i = firstBlock; i < firstBlock + lodBlockCount; ++i)
+	{
+		const uint32_t ix = (i % ChunkSideSize);
+		const uint32_t iy = (i / ChunkSideSize) % ChunkSideSize;
+		const uint32_t iz = (i / ChunkSideSize) / ChunkSideSize;
+
+		const float fl = sizeMultiplier;
+		const float fx = (float)(origin.x * nodeSize) + ix * sizeMultiplier;
+		const float fy = (float)(origin.y * nodeSize) + iy * sizeMultiplier;
+		const float fz = (float)(origin.z * nodeSize) + iz * sizeMultiplier;
+
+		GridCell grid;
+		grid.p[0] = glm::vec3(fx,      fy,      fz);
+		grid.p[1] = glm::vec3(fx + fl, fy,      fz);
+		grid.p[2] = glm::vec3(fx + fl, fy + fl, fz);
+		grid.p[3] = glm::vec3(fx,      fy + fl, fz);
+		grid.p[4] = glm::vec3(fx,      fy,      fz + fl);
+		grid.p[5] = glm::vec3(fx + fl, fy,      fz + fl);
+		grid.p[6] = glm::vec3(fx + fl, fy + fl, fz + fl);
+		grid.p[7] = glm::vec3(fx,      fy + fl, fz + fl);
+
+		const uint32_t terrainSampleIndex = (iz * sampleGridSideSize * sampleGridSideSize) + (iy * sampleGridSideSize) + ix;
+
+		grid.val[0] = terrainSamples[terrainSampleIndex];
+		grid.val[1] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX];
+		grid.val[2] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX + terrainSampleOffsetY];
+		grid.val[3] = terrainSamples[terrainSampleIndex +                        terrainSampleOffsetY];
+		grid.val[4] = terrainSamples[terrainSampleIndex +                                               terrainSampleOffsetZ];
+		grid.val[5] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX +                        terrainSampleOffsetZ];
+		grid.val[6] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX + terrainSampleOffsetY + terrainSampleOffsetZ];
+		grid.val[7] = terrainSamples[terrainSampleIndex +                        terrainSampleOffsetY + terrainSampleOffsetZ];
+
+		polygonise(grid, 0.0, vertices, normals);
+
+		// After the plane's cells, so slabs still append up to the whole chunk's triangulation.
+		if ((i % lodPlaneBlockCount) == lodPlaneBlockCount - 1)
+		{
+			addPlaneSkirts(lodLevel, origin, terrainSamples, bands, iz, vertices, normals);
+		}
+	}
+}
+
+void packChunkBuffers(
+	const std::vector<glm::vec3>& vertices,
+	const std::vector<glm::vec3>& normals,
+	glm::vec3** outPositions,
+	glm::vec3** outNormals,
+	size_t* outVertexCount)
+{
+	ZoneScoped;
+
+	const auto vertexCount = vertices.size();
+
+	*outVertexCount = vertexCount;
+
+	if (vertexCount > 0) 
+	{
+		*outPositions = new glm::vec3[vertexCount];
+		*outNormals = new glm::vec3[vertexCount];
+
+		memcpy(*outPositions, vertices.data(), vertexCount * sizeof(glm::vec3));
+		memcpy(*outNormals, normals.data(), vertexCount * sizeof(glm::vec3));
+	}
+	else 
+	{
+		*outPositions = nullptr;
+		*outNormals = nullptr;
+	}
+}
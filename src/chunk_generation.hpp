@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint32_t ChunkSideSize = 32;
+constexpr uint32_t ChunkSideHalfSize = ChunkSideSize / 2;
+constexpr uint32_t ChunkMaxLOD = 5;
+
+// The CPU side of building a chunk, one function per pipeline stage. A chunk at LOD level l is a node
+// of the chunk octree, ChunkSideSize << l units across with ChunkSideSize cells of 1 << l units along
+// each side, sampled on a grid one sample wider. Its origin is counted in nodes of its own level.
+
+std::unique_ptr<float[]> sampleChunk(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin);
+
+// False if every sample is on the same side of the surface, the chunk has no triangles then.
+bool hasSurfaceCrossing(
+	const float* terrainSamples);
+
+// Also closes the chunk's faces along the surface with skirts, so cracks to neighbours of another LOD level
+// don't show.
+void triangulateChunk(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	const float* terrainSamples,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec3>& normals);
+
+// Slabs split one chunk along z so several jobs can work on it, planes are counted at the chunk's LOD.
+// A sample slab fills its planes of the chunk's sample grid, which has one more plane than there are 
+// cells. A triangulation slab reads the samples its cells touch, one plane past its last cell, and the 
+// samples on the chunk's faces for the skirts. Appending the slabs' triangulations in order gives the same 
+// result as triangulateChunk.
+
+void sampleChunkSlab(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	uint32_t firstPlane,
+	uint32_t planeCount,
+	float* terrainSamples);
+
+void triangulateChunkSlab(
+	uint32_t lodLevel,
+	const glm::i32vec3& origin,
+	const float* terrainSamples,
+	uint32_t firstPlane,
+	uint32_t planeCount,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec3>& normals);
+
+// Copies the triangulation into exactly sized arrays, or null ones if it is empty.
+void packChunkBuffers(
+	const std::vector<glm::vec3>& vertices,
+	const std::vector<glm::vec3>& normals,
+	glm::vec3** outPositions,
+	glm::vec3** outNormals,
+	size_t* outVertexCount);
@@ -0,0 +1,184 @@
+#include "chunk_lod.hpp"
+
+#include <tracy/Tracy.hpp>
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
+#include <algorithm>
+
+static float getNodeSize(uint32_t lodLevel)
+{
+	return (float)(ChunkSideSize << lodLevel);
+}
+
+float getLodNodeDistance(const glm::vec3& point, const glm::i32vec3& position, uint32_t lodLevel)
+{
+	const float nodeSize = getNodeSize(lodLevel);
+	const glm::vec3 boxMin = glm::vec3(position) * nodeSize;
+	const glm::vec3 boxMax = boxMin + nodeSize;
+
+	const glm::vec3 outside = glm::max(glm::max(boxMin - point, point - boxMax), glm::vec3(0.0f));
+	return glm::length(outside);
+}
+
+static bool isInRegion(const glm::i32vec3& position, const glm::i32vec3& regionMin, const glm::i32vec3& regionMax)
+{
+	return
+		position.x >= regionMin.x && position.y >= regionMin.y && position.z >= regionMin.z &&
+		position.x < regionMax.x && position.y < regionMax.y && position.z < regionMax.z;
+}
+
+ChunkLodSelector::ChunkLodSelector()
+	: m_rootCount(0)
+	, m_leafCount(0)
+	, m_estimatedVertexCount(0.0f)
+{
+}
+
+void ChunkLodSelector::select(const ChunkLodView& view, const ChunkLodBudget& budget)
+{
+	ZoneScoped;
+
+	m_nodes.clear();
+	m_splitCandidates.clear();
+
+	// The coarsest level's nodes in range are the roots, however many chunks that ends up as.
+	const float rootSize = getNodeSize(ChunkMaxLOD);
+	const glm::i32vec3 searchMin = glm::max(
+		glm::i32vec3(glm::floor((view.position - view.radius) / rootSize)),
+		view.regionMin[ChunkMaxLOD]);
+	const glm::i32vec3 searchMax = glm::min(
+		glm::i32vec3(glm::floor((view.position + view.radius) / rootSize)) + 1,
+		view.regionMax[ChunkMaxLOD]);
+
+	for (int32_t z = searchMin.z; z < searchMax.z; ++z)
+	{
+		for (int32_t y = searchMin.y; y < searchMax.y; ++y)
+		{
+			for (int32_t x = searchMin.x; x < searchMax.x; ++x)
+			{
+				const glm::i32vec3 position(x, y, z);
+				if (getLodNodeDistance(view.position, position, ChunkMaxLOD) < view.radius)
+				{
+					_addNode(view, position, ChunkMaxLOD);
+				}
+			}
+		}
+	}
+
+	m_rootCount = m_nodes.size();
+	m_leafCount = (uint32_t)m_rootCount;
+	m_estimatedVertexCount = (float)m_rootCount * view.averageVertexCounts[ChunkMaxLOD];
+
+	// std heaps keep the largest element on top.
+	auto compareScreenErrors = [this](uint32_t a, uint32_t b) {
+		return m_nodes[a].screenError < m_nodes[b].screenError;
+	};
+
+	for (uint32_t i = 0; i < (uint32_t)m_rootCount; ++i)
+	{
+		m_splitCandidates.push_back(i);
+	}
+	std::make_heap(m_splitCandidates.begin(), m_splitCandidates.end(), compareScreenErrors);
+
+	while (!m_splitCandidates.empty())
+	{
+		std::pop_heap(m_splitCandidates.begin(), m_splitCandidates.end(), compareScreenErrors);
+		const uint32_t nodeIndex = m_splitCandidates.back();
+		m_splitCandidates.pop_back();
+
+		// Everything left has a smaller error.
+		if (m_nodes[nodeIndex].screenError <= budget.maxScreenError)
+		{
+			break;
+		}
+
+		// One that doesn't fit can still leave room for a smaller split further down the queue.
+		if (!_split(view, budget, nodeIndex))
+		{
+			continue;
+		}
+
+		const ChunkLodNode& node = m_nodes[nodeIndex];
+		for (uint32_t i = node.firstChild; i < node.firstChild + node.childCount; ++i)
+		{
+			if (m_nodes[i].lodLevel > 0)
+			{
+				m_splitCandidates.push_back(i);
+				std::push_heap(m_splitCandidates.begin(), m_splitCandidates.end(), compareScreenErrors);
+			}
+		}
+	}
+
+	TracyPlot("LOD Node Count", (int64_t)m_nodes.size());
+	TracyPlot("LOD Leaf Count", (int64_t)m_leafCount);
+	TracyPlot("LOD Estimated Vertex Count", (int64_t)m_estimatedVertexCount);
+}
+
+void ChunkLodSelector::_addNode(const ChunkLodView& view, const glm::i32vec3& position, uint32_t lodLevel)
+{
+	// The camera can be inside the node, which is as close as it gets to a cell filling the screen.
+	const float distance = std::max(getLodNodeDistance(view.position, position, lodLevel), 1.0f);
+
+	ChunkLodNode node;
+	node.position = position;
+	node.lodLevel = lodLevel;
+	node.firstChild = 0;
+	node.childCount = 0;
+	node.screenError = (float)(1 << lodLevel) * view.projectionScale / distance;
+	m_nodes.push_back(node);
+}
+
+bool ChunkLodSelector::_split(const ChunkLodView& view, const ChunkLodBudget& budget, uint32_t nodeIndex)
+{
+	const glm::i32vec3 parentPosition = m_nodes[nodeIndex].position;
+	const uint32_t childLevel = m_nodes[nodeIndex].lodLevel - 1;
+
+	glm::i32vec3 children[8];
+	uint32_t childCount = 0;
+
+	for (int32_t i = 0; i < 8; ++i)
+	{
+		const glm::i32vec3 position = parentPosition * 2 + glm::i32vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+		if (getLodNodeDistance(view.position, position, childLevel) >= view.radius)
+		{
+			continue;
+		}
+
+		// Leaving it out would leave a hole in view, the parent has to stay.
+		if (!isInRegion(position, view.regionMin[childLevel], view.regionMax[childLevel]))
+		{
+			return false;
+		}
+
+		children[childCount++] = position;
+	}
+
+	if (childCount == 0)
+	{
+		return false;
+	}
+
+	const uint32_t leafCount = m_leafCount - 1 + childCount;
+	const float estimatedVertexCount = m_estimatedVertexCount -
+		view.averageVertexCounts[childLevel + 1] +
+		(float)childCount * view.averageVertexCounts[childLevel];
+
+	if (leafCount > budget.maxChunks || estimatedVertexCount > (float)budget.maxVertices)
+	{
+		return false;
+	}
+
+	m_nodes[nodeIndex].firstChild = (uint32_t)m_nodes.size();
+	m_nodes[nodeIndex].childCount = childCount;
+
+	for (uint32_t i = 0; i < childCount; ++i)
+	{
+		_addNode(view, children[i], childLevel);
+	}
+
+	m_leafCount = leafCount;
+	m_estimatedVertexCount = estimatedVertexCount;
+	return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chunk_generation.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// A node of the chunk octree, see sampleChunk for what a chunk at each LOD level covers.
+struct ChunkLodNode
+{
+	glm::i32vec3 position;
+	uint32_t lodLevel;
+	// Children are next to each other in the selection, a leaf has none. Only the children in view
+	// range are there, so a node can have fewer than eight.
+	uint32_t firstChild;
+	uint32_t childCount;
+	// Pixels one of the node's cells covers at the node's closest point to the camera.
+	float screenError;
+};
+
+struct ChunkLodView
+{
+	glm::vec3 position;
+	// See Camera::getProjectionScale.
+	float projectionScale;
+	// Radius of the streamed sphere around the camera, nodes entirely outside it are left out.
+	float radius;
+	// The nodes each level can be built for, [regionMin, regionMax) in the level's node coordinates.
+	// A node is only split if every child in view range is inside its level's region.
+	glm::i32vec3 regionMin[ChunkMaxLOD + 1];
+	glm::i32vec3 regionMax[ChunkMaxLOD + 1];
+	// What a loaded node of each level is expected to cost.
+	float averageVertexCounts[ChunkMaxLOD + 1];
+};
+
+struct ChunkLodBudget
+{
+	// Leaves are split until their screen error is at most this many pixels.
+	float maxScreenError = 2.0f;
+	// Caps on the leaves, the chunks that end up drawn, and on their estimated vertices.
+	uint32_t maxChunks = 8192;
+	size_t maxVertices = 8 * 1024 * 1024;
+};
+
+// Distance from a point to the closest point of a node's box, zero inside it.
+float getLodNodeDistance(const glm::vec3& point, const glm::i32vec3& position, uint32_t lodLevel);
+
+// Picks the octree cut to draw from a view. Starts from the coarsest nodes in range and keeps
+// splitting the leaf with the largest screen error, until every leaf is fine enough or splitting any
+// further would go over budget. Both are bounded however far the view reaches.
+class ChunkLodSelector
+{
+public:
+	ChunkLodSelector();
+
+	void select(const ChunkLodView& view, const ChunkLodBudget& budget);
+
+	// Roots first, every node ahead of its children. Valid until the next select.
+	inline const std::vector<ChunkLodNode>& getNodes() const { return m_nodes; }
+	inline size_t getRootCount() const { return m_rootCount; }
+	inline uint32_t getLeafCount() const { return m_leafCount; }
+	inline float getEstimatedVertexCount() const { return m_estimatedVertexCount; }
+
+private:
+	void _addNode(const ChunkLodView& view, const glm::i32vec3& position, uint32_t lodLevel);
+	bool _split(const ChunkLodView& view, const ChunkLodBudget& budget, uint32_t nodeIndex);
+
+	std::vector<ChunkLodNode> m_nodes;
+	// Leaves that may still be split, a heap on screen error.
+	std::vector<uint32_t> m_splitCandidates;
+	size_t m_rootCount;
+	uint32_t m_leafCount;
+	float m_estimatedVertexCount;
+};
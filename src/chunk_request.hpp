@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// The CPU side of a requested chunk, shared by everyone who awaited it.
+struct ChunkMesh
+{
+	// Triangle list, empty if the surface doesn't cross the chunk.
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec3> normals;
+};
+
+struct ChunkRequestResult
+{
+	glm::i32vec3 position;
+	uint32_t lodLevel;
+	// ChunkSideSize + 1 samples per side laid out like sampleChunk's, negative inside the terrain.
+	std::shared_ptr<const float[]> density;
+	std::shared_ptr<const ChunkMesh> mesh;
+};
+
+// Shared by the awaitable, the job building the chunk and the work item that completes it.
+struct ChunkRequestState
+{
+	ChunkRequestResult result;
+
+	// Main thread only, the job hands the state over through the main thread work queue.
+	bool isDone = false;
+	std::vector<std::coroutine_handle<>> waiters;
+};
+
+// Returned by World::requestChunk. The chunk is built by a job as soon as the chunk job budget allows and
+// co_await only waits for it, so several requests can be started before awaiting any of them. Await it on
+// the main thread, the coroutine is resumed from World::update once the chunk is done. A coroutine still
+// waiting when the world is destroyed is destroyed with it, without being resumed.
+class ChunkRequest
+{
+public:
+	explicit ChunkRequest(std::shared_ptr<ChunkRequestState> state)
+		: m_state(std::move(state))
+	{
+	}
+
+	bool isDone() const { return m_state->isDone; }
+
+	bool await_ready() const noexcept { return m_state->isDone; }
+	void await_suspend(std::coroutine_handle<> waiter) { m_state->waiters.push_back(waiter); }
+	// By value, the awaitable is usually a temporary that is gone before the result is used.
+	ChunkRequestResult await_resume() const { return m_state->result; }
+
+private:
+	std::shared_ptr<ChunkRequestState> m_state;
+};
+
+// Return type for coroutines that await chunk requests. Runs eagerly up to the first co_await and
+// destroys itself when it finishes, nothing waits on it.
+struct AsyncTask
+{
+	struct promise_type
+	{
+		AsyncTask get_return_object() { return AsyncTask(); }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
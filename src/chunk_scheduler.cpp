@@ -0,0 +1,85 @@
+#include "chunk_scheduler.hpp"
+
+#include <algorithm>
+
+static bool compareRequests(const ChunkScheduler::Request& a, const ChunkScheduler::Request& b)
+{
+	// std heaps keep the largest element on top.
+	return a.priority > b.priority;
+}
+
+static bool isSameRequest(const ChunkScheduler::Request& a, const ChunkScheduler::Request& b)
+{
+	return a.position == b.position && a.lodLevel == b.lodLevel && a.cell == b.cell;
+}
+
+ChunkScheduler::ChunkScheduler()
+	: m_isSnapshotOut(false)
+{
+}
+
+void ChunkScheduler::_takeSnapshot()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_snapshot.assign(m_heap.begin(), m_heap.end());
+	m_isSnapshotOut = true;
+}
+
+void ChunkScheduler::_publishSnapshot()
+{
+	std::vector<Request> taken;
+	for (;;)
+	{
+		// Only a handful are popped per rebuild, filtering again is cheaper than holding the lock.
+		if (!taken.empty())
+		{
+			m_snapshot.erase(std::remove_if(m_snapshot.begin(), m_snapshot.end(), [&taken](const Request& request) {
+				return std::any_of(taken.begin(), taken.end(), [&request](const Request& other) {
+					return isSameRequest(request, other);
+				});
+			}), m_snapshot.end());
+			taken.clear();
+		}
+
+		std::make_heap(m_snapshot.begin(), m_snapshot.end(), compareRequests);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_taken.empty())
+		{
+			m_heap.swap(m_snapshot);
+			m_isSnapshotOut = false;
+			break;
+		}
+
+		taken.swap(m_taken);
+	}
+
+	m_snapshot.clear();
+}
+
+bool ChunkScheduler::pop(Request& outRequest)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_heap.empty())
+	{
+		return false;
+	}
+
+	std::pop_heap(m_heap.begin(), m_heap.end(), compareRequests);
+	outRequest = m_heap.back();
+	m_heap.pop_back();
+
+	if (m_isSnapshotOut)
+	{
+		m_taken.push_back(outRequest);
+	}
+
+	return true;
+}
+
+size_t ChunkScheduler::queuedCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_heap.size();
+}
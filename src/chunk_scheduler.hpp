@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <cstdint>
+
+// Missing chunks ordered by priority, lowest value first. The main thread updates the queue whenever
+// the streaming region changes and workers pop from it, so chunks are generated strictly in order.
+// merge and reprioritize are main thread only.
+// Which chunks are in flight is tracked by the chunk grid, the scheduler only orders them.
+class ChunkScheduler
+{
+public:
+	struct Request
+	{
+		glm::i32vec3 position;
+		uint32_t lodLevel;
+		float priority;
+		// Opaque to the scheduler, the state of the chunk's grid cell when it was requested.
+		uint32_t cell;
+	};
+
+	// Queues the given requests, consuming the list, and drops the queued requests isWanted(request)
+	// rejects. Every priority is recomputed from getPriority(request), the region has moved.
+	template<class W, class F>
+	void merge(std::vector<Request>& requests, const W& isWanted, const F& getPriority)
+	{
+		_takeSnapshot();
+
+		m_snapshot.erase(std::remove_if(m_snapshot.begin(), m_snapshot.end(), [&isWanted](const Request& request) {
+			return !isWanted(request);
+		}), m_snapshot.end());
+
+		m_snapshot.insert(m_snapshot.end(), requests.begin(), requests.end());
+		requests.clear();
+
+		for (Request& request : m_snapshot)
+		{
+			request.priority = getPriority(request);
+		}
+
+		_publishSnapshot();
+	}
+
+	// Recomputes the priority of every queued request from getPriority(request), for when the
+	// ordering goes stale without the set of missing chunks changing, e.g. the camera turning.
+	template<class F>
+	void reprioritize(const F& getPriority)
+	{
+		_takeSnapshot();
+
+		for (Request& request : m_snapshot)
+		{
+			request.priority = getPriority(request);
+		}
+
+		_publishSnapshot();
+	}
+
+	ChunkScheduler();
+
+	bool pop(Request& outRequest);
+
+	size_t queuedCount();
+
+private:
+	// Priorities are worked out on a copy, workers only wait for the copy and the swap. What they pop
+	// in between is recorded and left out of the copy before it replaces the heap.
+	void _takeSnapshot();
+	void _publishSnapshot();
+
+	std::mutex m_mutex;
+	std::vector<Request> m_heap;
+	// Requests popped while a snapshot is out.
+	std::vector<Request> m_taken;
+	bool m_isSnapshotOut;
+	// Main thread only, between taking and publishing a snapshot.
+	std::vector<Request> m_snapshot;
+};
@@ -2,76 +2,104 @@
 
 #include <world.hpp>
 
-#define MAX_CHUNKS 64 * 1024
-#define INDEX_MASK 0xffff
-#define NEW_CHUNK_ID_ADD 0x10000
+// Slots are added a page of the index table at a time.
+#define CHUNK_SLOT_GROWTH 4096
+#define NO_CHUNK_INDEX UINT32_MAX
 
 Chunks::Chunks(World& world)
 	: m_world(world)
-	, m_capacity(MAX_CHUNKS)
 	, m_count(0)
+	, m_slotCount(0)
+	, m_freelistEnqueue(NO_CHUNK_INDEX)
+	, m_freelistDequeue(NO_CHUNK_INDEX)
 {
-	m_indices.reset(new ChunkIndex[m_capacity]);
-	for (size_t i = 0; i < m_capacity; ++i) {
-		m_indices[i].id = static_cast<uint32_t>(i);
-		m_indices[i].next = static_cast<uint16_t>(i + 1);
-	}
-
-	m_freelistDequeue = 0;
-	m_freelistEnqueue = static_cast<uint16_t>(m_capacity - 1);
-
-	m_chunkIDs.reset(new uint32_t[m_capacity]);
-
-	positions.reset(new glm::i32vec3[m_capacity]);
-	//boundingBoxes.reset(new DirectX::BoundingBox[m_capacity]);
-	visuals.reset(new VisualChunk[m_capacity]);
 }
 
 bool Chunks::has(ChunkHandle handle) const
 {
-	const ChunkIndex& in = m_indices[handle.id & INDEX_MASK];
-	return in.id == handle.id && in.index != USHRT_MAX;
+	if (handle.slot >= m_slotCount)
+	{
+		return false;
+	}
+
+	const ChunkIndex& in = m_indices[handle.slot];
+	return in.generation == handle.generation && in.index != NO_CHUNK_INDEX;
 }
 
 uint32_t Chunks::lookup(ChunkHandle handle) const
 {
-	const ChunkIndex& in = m_indices[handle.id & INDEX_MASK];
+	const ChunkIndex& in = m_indices[handle.slot];
 	return in.index;
 }
 
 ChunkHandle Chunks::reverseLookup(uint32_t index) const
 {
-	const uint32_t id = m_chunkIDs[index];
-	return ChunkHandle{ id };
+	const uint32_t slot = m_chunkSlots[index];
+	return ChunkHandle{ slot, m_indices[slot].generation };
 }
 
 ChunkHandle Chunks::add()
 {
-	ChunkIndex& in = m_indices[m_freelistDequeue];
+	if (m_freelistDequeue == NO_CHUNK_INDEX)
+	{
+		_growIndices();
+	}
+
+	const uint32_t slot = m_freelistDequeue;
+	ChunkIndex& in = m_indices[slot];
 	m_freelistDequeue = in.next;
-	in.id += NEW_CHUNK_ID_ADD;
-	in.index = static_cast<uint16_t>(m_count++);
-	uint32_t& chunkId = m_chunkIDs[in.index];
-	chunkId = in.id;
-	return ChunkHandle{ chunkId };
+	if (m_freelistDequeue == NO_CHUNK_INDEX)
+	{
+		m_freelistEnqueue = NO_CHUNK_INDEX;
+	}
+
+	positions.reserve(m_count + 1);
+	visuals.reserve(m_count + 1);
+	lodLevels.reserve(m_count + 1);
+	isDrawn.reserve(m_count + 1);
+	lastWanted.reserve(m_count + 1);
+	m_chunkSlots.reserve(m_count + 1);
+
+	++in.generation;
+	in.index = static_cast<uint32_t>(m_count++);
+	m_chunkSlots[in.index] = slot;
+	// Hidden until the LOD selection has seen it.
+	isDrawn[in.index] = false;
+	lastWanted[in.index] = 0;
+	return ChunkHandle{ slot, in.generation };
 }
 
 void Chunks::remove(ChunkHandle handle)
 {
-	ChunkIndex& in = m_indices[handle.id & INDEX_MASK];
+	ChunkIndex& in = m_indices[handle.slot];
 
-	uint32_t& chunkId = m_chunkIDs[in.index];
+	uint32_t& chunkSlot = m_chunkSlots[in.index];
 	const size_t lastIndex = --m_count;
-	chunkId = m_chunkIDs[lastIndex];
+	chunkSlot = m_chunkSlots[lastIndex];
 	
 	m_world._freeChunkBuffers(visuals[in.index]);
 	_move(in.index, lastIndex);
 
-	m_indices[chunkId & INDEX_MASK].index = in.index;
+	m_indices[chunkSlot].index = in.index;
 
-	in.index = USHRT_MAX;
-	m_indices[m_freelistEnqueue].next = handle.id & INDEX_MASK;
-	m_freelistEnqueue = handle.id & INDEX_MASK;
+	in.index = NO_CHUNK_INDEX;
+	in.next = NO_CHUNK_INDEX;
+	if (m_freelistEnqueue == NO_CHUNK_INDEX)
+	{
+		m_freelistDequeue = handle.slot;
+	}
+	else
+	{
+		m_indices[m_freelistEnqueue].next = handle.slot;
+	}
+	m_freelistEnqueue = handle.slot;
+
+	positions.trim(m_count);
+	visuals.trim(m_count);
+	lodLevels.trim(m_count);
+	isDrawn.trim(m_count);
+	lastWanted.trim(m_count);
+	m_chunkSlots.trim(m_count);
 
 	/*positions[index] = positions[count - 1];
 	boundingBoxes[index] = boundingBoxes[count - 1];
@@ -80,10 +108,30 @@ void Chunks::remove(ChunkHandle handle)
 	lodLevel[index] = lodLevel[count - 1];*/
 }
 
+void Chunks::_growIndices()
+{
+	const uint32_t firstSlot = m_slotCount;
+	m_slotCount += CHUNK_SLOT_GROWTH;
+	m_indices.reserve(m_slotCount);
+
+	for (uint32_t slot = firstSlot; slot < m_slotCount; ++slot)
+	{
+		m_indices[slot].generation = 0;
+		m_indices[slot].index = NO_CHUNK_INDEX;
+		m_indices[slot].next = slot + 1 < m_slotCount ? slot + 1 : NO_CHUNK_INDEX;
+	}
+
+	m_freelistDequeue = firstSlot;
+	m_freelistEnqueue = m_slotCount - 1;
+}
+
 void Chunks::_move(size_t dst, size_t src)
 {
 	positions[dst] = positions[src];
 	//boundingBoxes[dst] = boundingBoxes[src];
 	visuals[dst] = visuals[src];
+	lodLevels[dst] = lodLevels[src];
+	isDrawn[dst] = isDrawn[src];
+	lastWanted[dst] = lastWanted[src];
 
 }
@@ -5,6 +5,8 @@
 
 #include <glm/vec3.hpp>
 
+#include <paged_array.hpp>
+
 #include <vector>
 #include <memory>
 
@@ -30,14 +32,19 @@ struct VisualChunk
 
 struct ChunkHandle
 {
-	uint32_t id;
+	// Slot in the index table, and how many times the slot had been handed out when the handle was.
+	// Generations start at 1, a zeroed handle is never valid.
+	uint32_t slot;
+	uint32_t generation;
 };
 
 struct ChunkIndex
 {
-	uint32_t id;
-	uint16_t index;
-	uint16_t next;
+	uint32_t generation;
+	// Where the slot's chunk is in the dense arrays, UINT32_MAX while the slot is free.
+	uint32_t index;
+	// The next free slot, while on the freelist.
+	uint32_t next;
 };
 
 class Chunks
@@ -52,22 +59,34 @@ public:
 	ChunkHandle add();
 	void remove(ChunkHandle handle);
 
-	std::unique_ptr<glm::i32vec3[]> positions;
-	//std::unique_ptr<DirectX::BoundingBox[]> boundingBoxes;
-	std::unique_ptr<VisualChunk[]> visuals;
+	// Dense, indexed by lookup(). Pages are added and freed as the chunk count changes.
+	PagedArray<glm::i32vec3> positions;
+	//PagedArray<DirectX::BoundingBox> boundingBoxes;
+	PagedArray<VisualChunk> visuals;
+	// Positions are in nodes of the chunk's LOD level.
+	PagedArray<uint8_t> lodLevels;
+	// Whether the chunk is part of what is drawn, it can be resident and hidden by another level.
+	PagedArray<bool> isDrawn;
+	// Which of World's drawn chunk updates last found the chunk wanted by the LOD selection. Chunks it
+	// stopped wanting are kept hidden for a while, the least recently wanted are unloaded first.
+	PagedArray<uint32_t> lastWanted;
 
 	__forceinline size_t count() const { return m_count; }
 
 private:
 	void _move(size_t dst, size_t src);
+	void _growIndices();
 
 	size_t m_count;
-	size_t m_capacity;
 
-	std::unique_ptr<ChunkIndex[]> m_indices;
-	std::unique_ptr<uint32_t[]> m_chunkIDs;
-	uint16_t m_freelistEnqueue;
-	uint16_t m_freelistDequeue;
+	// Slots only ever grow in number, handles refer to them.
+	PagedArray<ChunkIndex> m_indices;
+	uint32_t m_slotCount;
+	// The slot of each chunk in the dense arrays.
+	PagedArray<uint32_t> m_chunkSlots;
+	// Freed slots are reused oldest first, so generations go round as slowly as possible.
+	uint32_t m_freelistEnqueue;
+	uint32_t m_freelistDequeue;
 
 private:
 	World& m_world;
@@ -0,0 +1,67 @@
+#include "generation_throttle.hpp"
+
+#include <algorithm>
+
+// Frames this much over the target count as over budget, vsync jitter stays below it.
+constexpr float OverBudgetTolerance = 1.1f;
+
+constexpr float FrameTimeSmoothing = 0.1f;
+constexpr float BudgetIncreasePerFrame = 0.1f;
+constexpr float BudgetDecreaseFactor = 0.7f;
+// A cut takes a frame or two to show up in the frame time, don't cut again before it had the chance.
+constexpr uint32_t DecreaseCooldownFrames = 4;
+
+GenerationThrottle::GenerationThrottle(float targetFrameTime, uint32_t maxJobCount)
+	: m_targetFrameTime(targetFrameTime)
+	, m_smoothedFrameTime(targetFrameTime)
+	, m_jobBudget((float)std::max(maxJobCount, 1u))
+	, m_maxJobCount((float)std::max(maxJobCount, 1u))
+	, m_cooldownFrames(0)
+	, m_isPaused(false)
+{
+}
+
+uint32_t GenerationThrottle::pause()
+{
+	m_isPaused = true;
+	return getJobBudget();
+}
+
+uint32_t GenerationThrottle::resume()
+{
+	m_isPaused = false;
+	return getJobBudget();
+}
+
+void GenerationThrottle::setMaxJobCount(uint32_t maxJobCount)
+{
+	m_maxJobCount = (float)std::max(maxJobCount, 1u);
+	m_jobBudget = std::min(m_jobBudget, m_maxJobCount);
+}
+
+uint32_t GenerationThrottle::update(float frameTime)
+{
+	m_smoothedFrameTime += (frameTime - m_smoothedFrameTime) * FrameTimeSmoothing;
+
+	if (m_cooldownFrames > 0)
+	{
+		--m_cooldownFrames;
+	}
+
+	if (frameTime > m_targetFrameTime * OverBudgetTolerance)
+	{
+		if (m_cooldownFrames == 0)
+		{
+			m_jobBudget *= BudgetDecreaseFactor;
+			m_cooldownFrames = DecreaseCooldownFrames;
+		}
+	}
+	else if (m_smoothedFrameTime <= m_targetFrameTime * OverBudgetTolerance)
+	{
+		// Only grow while the average is in budget too, otherwise every other frame spiking would hold it up.
+		m_jobBudget += BudgetIncreasePerFrame;
+	}
+
+	m_jobBudget = std::clamp(m_jobBudget, 1.0f, m_maxJobCount);
+	return getJobBudget();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// Picks how many chunk jobs may run at once from the main thread's frame time. Additive increase while
+// frames come in under the target, multiplicative decrease when one runs over it, so generation backs
+// off within a frame of a spike and creeps back up to full throughput once frames are cheap again.
+class GenerationThrottle
+{
+public:
+	GenerationThrottle(float targetFrameTime, uint32_t maxJobCount);
+
+	// Call once per frame, returns the new job budget. Never goes below one job so streaming can't stall.
+	uint32_t update(float frameTime);
+
+	// The budget is zero while paused, for when the main thread needs every worker for a moment. Resuming
+	// carries on from the budget before the pause. Both return the new budget.
+	uint32_t pause();
+	uint32_t resume();
+
+	void setTargetFrameTime(float seconds) { m_targetFrameTime = seconds; }
+	void setMaxJobCount(uint32_t maxJobCount);
+
+	inline uint32_t getJobBudget() const { return m_isPaused ? 0 : (uint32_t)m_jobBudget; }
+	inline float getSmoothedFrameTime() const { return m_smoothedFrameTime; }
+	inline float getTargetFrameTime() const { return m_targetFrameTime; }
+
+private:
+	float m_targetFrameTime;
+	float m_smoothedFrameTime;
+	float m_jobBudget;
+	float m_maxJobCount;
+	uint32_t m_cooldownFrames;
+	bool m_isPaused;
+};
@@ -0,0 +1,381 @@
+#include "jobs.hpp"
+
+#include <mpmc_bounded_queue.hpp>
+#include <tracy/Tracy.hpp>
+
+#include <vector>
+#include <thread>
+#include <semaphore>
+#include <cassert>
+
+namespace jobs
+{
+
+struct Job
+{
+	JobFunction function;
+	void* data;
+	Counter* counter;
+};
+
+// Chase-Lev work stealing deque, see "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013).
+// The owning thread pushes and pops at the bottom, other threads steal from the top.
+class WorkStealingDeque
+{
+public:
+	static constexpr int64_t Capacity = 4096;
+
+	WorkStealingDeque()
+		: m_top(0)
+		, m_bottom(0)
+	{
+		for (std::atomic<Job*>& job : m_jobs)
+		{
+			job.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	bool push(Job* job)
+	{
+		const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		const int64_t top = m_top.load(std::memory_order_acquire);
+
+		if (bottom - top >= Capacity)
+		{
+			return false;
+		}
+
+		m_jobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	Job* pop()
+	{
+		const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = m_jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// Last job, race the thieves for it.
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	Job* steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+
+		Job* job = m_jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+
+		return job;
+	}
+
+private:
+	alignas(64) std::atomic<int64_t> m_top;
+	alignas(64) std::atomic<int64_t> m_bottom;
+	alignas(64) std::atomic<Job*> m_jobs[Capacity];
+};
+
+// Deque 0 belongs to the thread that called init, the rest to the workers.
+static std::unique_ptr<WorkStealingDeque[]> deques;
+static size_t dequeCount = 0;
+static std::vector<std::thread> workers;
+static std::atomic<bool> isRunning{ false };
+static bool isMainThreadPinned = false;
+
+// Jobs from threads without a deque, and overflow from full deques.
+static mpmc_bounded_queue<Job*> injectedJobs(4096);
+
+// Idle workers block on the semaphore, it is released once per job queued while any of them sleep.
+static std::counting_semaphore<> wakeSignal(0);
+static std::atomic<uint32_t> sleepingWorkerCount{ 0 };
+
+static thread_local size_t threadIndex = SIZE_MAX;
+static thread_local uint32_t stealSeed = 0;
+
+static void notifyWorkers()
+{
+	// Pairs with the fence in workerThreadEP, either the worker sees the new job or we see the worker.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (sleepingWorkerCount.load(std::memory_order_relaxed) > 0)
+	{
+		wakeSignal.release();
+	}
+}
+
+static void execute(Job* job)
+{
+	job->function(job->data);
+
+	if (job->counter)
+	{
+		job->counter->value.fetch_sub(1, std::memory_order_release);
+	}
+
+	delete job;
+}
+
+static Job* findJob()
+{
+	if (threadIndex < dequeCount)
+	{
+		if (Job* job = deques[threadIndex].pop())
+		{
+			return job;
+		}
+	}
+
+	Job* injected;
+	if (injectedJobs.dequeue(injected))
+	{
+		return injected;
+	}
+
+	// xorshift, start stealing at a random victim so thieves spread out.
+	stealSeed ^= stealSeed << 13;
+	stealSeed ^= stealSeed >> 17;
+	stealSeed ^= stealSeed << 5;
+
+	for (size_t i = 0; i < dequeCount; ++i)
+	{
+		const size_t victim = (stealSeed + i) % dequeCount;
+		if (victim == threadIndex)
+		{
+			continue;
+		}
+
+		if (Job* job = deques[victim].steal())
+		{
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+static void workerThreadEP(size_t index, uint32_t processor, bool backgroundPriority)
+{
+	if (processor != topology::NoProcessor)
+	{
+		topology::pinCurrentThread(processor);
+	}
+
+	if (backgroundPriority)
+	{
+		topology::setCurrentThreadBackground();
+	}
+
+	threadIndex = index;
+	stealSeed = (uint32_t)index * 0x9e3779b9u + 1u;
+
+	while (isRunning.load(std::memory_order_relaxed))
+	{
+		if (Job* job = findJob())
+		{
+			execute(job);
+			continue;
+		}
+
+		sleepingWorkerCount.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// Look once more, a job queued before the count went up did not signal.
+		if (Job* job = findJob())
+		{
+			sleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+			execute(job);
+			continue;
+		}
+
+		{
+			ZoneScopedN("Sleep");
+			wakeSignal.acquire();
+		}
+
+		sleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+void init(const topology::WorkerPlacement& placement)
+{
+	assert(!isRunning);
+
+	uint32_t mainProcessor;
+	const std::vector<uint32_t> workerProcessors = topology::planWorkers(placement, &mainProcessor);
+	const size_t count = workerProcessors.size();
+
+	if (mainProcessor != topology::NoProcessor)
+	{
+		isMainThreadPinned = topology::pinCurrentThread(mainProcessor);
+	}
+
+	dequeCount = count + 1;
+	deques.reset(new WorkStealingDeque[dequeCount]);
+
+	threadIndex = 0;
+	stealSeed = 0x2545f491u;
+
+	isRunning = true;
+
+	workers.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		workers[i] = std::thread(workerThreadEP, i + 1, workerProcessors[i], placement.backgroundPriority);
+	}
+}
+
+void shutdown()
+{
+	isRunning = false;
+	wakeSignal.release((std::ptrdiff_t)workers.size());
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+
+	// Nobody is left to run them.
+	for (size_t i = 0; i < dequeCount; ++i)
+	{
+		while (Job* job = deques[i].pop())
+		{
+			delete job;
+		}
+	}
+
+	Job* injected;
+	while (injectedJobs.dequeue(injected))
+	{
+		delete injected;
+	}
+
+	deques.reset();
+	dequeCount = 0;
+	threadIndex = SIZE_MAX;
+
+	if (isMainThreadPinned)
+	{
+		topology::unpinCurrentThread();
+		isMainThreadPinned = false;
+	}
+}
+
+size_t workerCount()
+{
+	return workers.size();
+}
+
+size_t currentThreadIndex()
+{
+	return threadIndex < dequeCount ? threadIndex : SIZE_MAX;
+}
+
+void run(JobFunction function, void* data, Counter* counter)
+{
+	if (counter)
+	{
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Job* job = new Job{ function, data, counter };
+
+	// The main thread's deque only holds forked jobs, wait there would pick up anything else.
+	if (threadIndex != 0 && threadIndex < dequeCount && deques[threadIndex].push(job))
+	{
+		notifyWorkers();
+		return;
+	}
+
+	if (!injectedJobs.enqueue(job))
+	{
+		// Everything is full, run it here rather than block.
+		execute(job);
+		return;
+	}
+
+	notifyWorkers();
+}
+
+void fork(JobFunction function, void* data, Counter* counter)
+{
+	counter->value.fetch_add(1, std::memory_order_relaxed);
+
+	Job* job = new Job{ function, data, counter };
+
+	if (threadIndex < dequeCount && deques[threadIndex].push(job))
+	{
+		notifyWorkers();
+		return;
+	}
+
+	if (!injectedJobs.enqueue(job))
+	{
+		execute(job);
+		return;
+	}
+
+	notifyWorkers();
+}
+
+static Job* findMainThreadJob(Counter* counter)
+{
+	Job* job = deques[0].pop();
+	if (job && job->counter != counter)
+	{
+		// Forked by an outer wait, leave it for that one or for a thief.
+		deques[0].push(job);
+		return nullptr;
+	}
+
+	return job;
+}
+
+void wait(Counter* counter)
+{
+	ZoneScoped;
+
+	const bool isMainThread = threadIndex == 0 && dequeCount != 0;
+
+	while (counter->value.load(std::memory_order_acquire) != 0)
+	{
+		if (Job* job = isMainThread ? findMainThreadJob(counter) : findJob())
+		{
+			execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <topology.hpp>
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace jobs
+{
+
+typedef void (*JobFunction)(void* data);
+
+// Number of unfinished jobs started with this counter. Wait on it to join them.
+struct Counter
+{
+	std::atomic<uint32_t> value{ 0 };
+};
+
+// Starts the workers planned by topology::planWorkers, by default one per physical core except the 
+// calling thread's. The calling thread is registered as the main thread, it only runs the jobs it 
+// forked itself while it waits on their counter, background work is left to the workers.
+void init(const topology::WorkerPlacement& placement = topology::WorkerPlacement());
+void shutdown();
+
+size_t workerCount();
+
+// 0 on the main thread and 1 to workerCount() on the workers, SIZE_MAX on threads the job system didn't start.
+size_t currentThreadIndex();
+
+// Queues function(data) for the workers, on the calling worker's deque or on the shared queue when 
+// called from the main thread. The counter is incremented right away and decremented once the job has returned.
+void run(JobFunction function, void* data, Counter* counter = nullptr);
+
+// Like run but always queues on the calling thread's deque, for short jobs the caller is about to wait on.
+void fork(JobFunction function, void* data, Counter* counter);
+
+// Runs queued jobs on the calling thread until the counter reaches zero. The main thread only runs its 
+// own forked jobs of that counter, so a frame never ends up running open-ended background work.
+void wait(Counter* counter);
+
+// Calls f(i) for every i in [0, count) from batches of batchSize indices and waits for all of them.
+template<class F>
+void parallelFor(size_t count, size_t batchSize, const F& f)
+{
+	struct Batch
+	{
+		const F* f;
+		size_t begin;
+		size_t end;
+	};
+
+	const size_t batchCount = (count + batchSize - 1) / batchSize;
+	std::unique_ptr<Batch[]> batches(new Batch[batchCount]);
+
+	Counter counter;
+	for (size_t i = 0; i < batchCount; ++i)
+	{
+		batches[i].f = &f;
+		batches[i].begin = i * batchSize;
+		batches[i].end = (i + 1) * batchSize < count ? (i + 1) * batchSize : count;
+
+		fork([](void* data) {
+			const Batch* batch = static_cast<const Batch*>(data);
+			for (size_t index = batch->begin; index < batch->end; ++index)
+			{
+				(*batch->f)(index);
+			}
+		}, &batches[i], &counter);
+	}
+
+	wait(&counter);
+}
+
+}
@@ -1,6 +1,11 @@
 #include <game.hpp>
 #include <input_windows.hpp>
 #include <graphics.hpp>
+#include <jobs.hpp>
+#include <chunk_benchmark.hpp>
+#include <queue_benchmark.hpp>
+#include <noise_benchmark.hpp>
+#include <noise_batch_benchmark.hpp>
 
 struct WindowData
 {
@@ -51,9 +56,35 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 #if defined(CONFIG_RETAIL)
 INT WINAPI WinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, PSTR /*pCmdLine*/, INT /*nCmdShow*/)
 #else
-int main(int /*argc*/, char* /*argv*/[])
+int main(int argc, char* argv[])
 #endif
 {
+#if !defined(CONFIG_RETAIL)
+	if (argc > 1 && strcmp(argv[1], "-chunkbench") == 0)
+	{
+		runChunkBenchmark();
+		return 0;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "-queuebench") == 0)
+	{
+		runQueueBenchmark();
+		return 0;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "-noisebench") == 0)
+	{
+		runNoiseBenchmark();
+		return 0;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "-batchbench") == 0)
+	{
+		runNoiseBatchBenchmark();
+		return 0;
+	}
+#endif
+
 	WNDCLASS wc;
 	ZeroMemory(&wc, sizeof(wc));
 	wc.lpszClassName = TEXT("surface");
@@ -94,6 +125,9 @@ int main(int /*argc*/, char* /*argv*/[])
 
 	// Init renderer.
 	graphics::init(hwnd);
+
+	// Init job threads, the main thread joins in whenever it waits on jobs.
+	jobs::init();
 	
 	// Init input.
 	std::unique_ptr<WindowsInput> input = std::make_unique<WindowsInput>(hwnd);
@@ -135,4 +169,7 @@ int main(int /*argc*/, char* /*argv*/[])
 
 		graphics::endFrame();
 	}
+
+	game.reset();
+	jobs::shutdown();
 }
\ No newline at end of file
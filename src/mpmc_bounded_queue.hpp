@@ -2,8 +2,14 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
-template<typename T>
+// With blocking set, wait_enqueue and wait_dequeue sleep on C++20 atomic waits until there is room or
+// an item. Every enqueue and dequeue then pays a fence to check for sleepers, so it is off by default.
+template<typename T, bool blocking = false>
 class mpmc_bounded_queue
 {
 public:
@@ -26,55 +32,88 @@ public:
 
 	bool enqueue(T const& data)
 	{
-		cell_t* cell;
-		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
-		for (;;)
-		{
-			cell = &buffer_[pos & buffer_mask_];
-			size_t seq =
-				cell->sequence_.load(std::memory_order_acquire);
-			intptr_t dif = (intptr_t)seq - (intptr_t)pos;
-			if (dif == 0)
-			{
-				if (enqueue_pos_.compare_exchange_weak
-				(pos, pos + 1, std::memory_order_relaxed))
-					break;
-			}
-			else if (dif < 0)
-				return false;
-			else
-				pos = enqueue_pos_.load(std::memory_order_relaxed);
-		}
+		cell_t* cell = claim_enqueue();
+		if (!cell)
+			return false;
 		cell->data_ = data;
-		cell->sequence_.store(pos + 1, std::memory_order_release);
+		publish_enqueue(cell);
+		return true;
+	}
+
+	bool enqueue(T&& data)
+	{
+		cell_t* cell = claim_enqueue();
+		if (!cell)
+			return false;
+		cell->data_ = std::move(data);
+		publish_enqueue(cell);
+		return true;
+	}
+
+	// Cells always hold a value, the one left behind by the last dequeue is destroyed and the new item
+	// constructed in its place.
+	template<typename... Args>
+	bool emplace(Args&&... args)
+	{
+		static_assert(std::is_nothrow_constructible_v<T, Args&&...>, "a throwing constructor would leave the cell empty");
+		cell_t* cell = claim_enqueue();
+		if (!cell)
+			return false;
+		std::destroy_at(&cell->data_);
+		std::construct_at(&cell->data_, std::forward<Args>(args)...);
+		publish_enqueue(cell);
 		return true;
 	}
 
 	bool dequeue(T& data)
 	{
-		cell_t* cell;
-		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
-		for (;;)
+		cell_t* cell = claim_dequeue();
+		if (!cell)
+			return false;
+		data = std::move(cell->data_);
+		publish_dequeue(cell);
+		return true;
+	}
+
+	// Claims as many free cells as it can, up to count, with a single CAS and copies that many items
+	// from data. Returns how many were enqueued, the rest didn't fit.
+	size_t enqueue_n(T const* data, size_t count)
+	{
+		size_t pos;
+		const size_t claimed = claim_range(enqueue_pos_, 0, count, pos);
+		for (size_t i = 0; i != claimed; i += 1)
 		{
-			cell = &buffer_[pos & buffer_mask_];
-			size_t seq =
-				cell->sequence_.load(std::memory_order_acquire);
-			intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
-			if (dif == 0)
-			{
-				if (dequeue_pos_.compare_exchange_weak
-				(pos, pos + 1, std::memory_order_relaxed))
-					break;
-			}
-			else if (dif < 0)
-				return false;
-			else
-				pos = dequeue_pos_.load(std::memory_order_relaxed);
+			cell_t* cell = &buffer_[(pos + i) & buffer_mask_];
+			cell->data_ = data[i];
+			publish_enqueue(cell);
 		}
-		data = cell->data_;
-		cell->sequence_.store
-		(pos + buffer_mask_ + 1, std::memory_order_release);
-		return true;
+		return claimed;
+	}
+
+	// Moves up to count items into data with a single CAS, returns how many.
+	size_t dequeue_n(T* data, size_t count)
+	{
+		size_t pos;
+		const size_t claimed = claim_range(dequeue_pos_, 1, count, pos);
+		for (size_t i = 0; i != claimed; i += 1)
+		{
+			cell_t* cell = &buffer_[(pos + i) & buffer_mask_];
+			data[i] = std::move(cell->data_);
+			publish_dequeue(cell);
+		}
+		return claimed;
+	}
+
+	void wait_enqueue(T data)
+	{
+		static_assert(blocking, "wait_enqueue needs a blocking queue");
+		wait_until([&] { return enqueue(std::move(data)); }, space_signal_, space_waiters_);
+	}
+
+	void wait_dequeue(T& data)
+	{
+		static_assert(blocking, "wait_dequeue needs a blocking queue");
+		wait_until([&] { return dequeue(data); }, item_signal_, item_waiters_);
 	}
 
 	size_t unsafe_size() const
@@ -89,6 +128,109 @@ private:
 		T                     data_;
 	};
 
+	// A cell at pos is ready to be written once its sequence is pos, and ready to be read once it is
+	// pos + 1. Writing sets it to pos + 1, reading to pos + buffer size, ready for the next lap.
+	cell_t* claim_enqueue()
+	{
+		size_t pos;
+		if (claim_range(enqueue_pos_, 0, 1, pos) == 0)
+			return nullptr;
+		return &buffer_[pos & buffer_mask_];
+	}
+
+	cell_t* claim_dequeue()
+	{
+		size_t pos;
+		if (claim_range(dequeue_pos_, 1, 1, pos) == 0)
+			return nullptr;
+		return &buffer_[pos & buffer_mask_];
+	}
+
+	size_t claim_range(std::atomic<size_t>& position, size_t ready_offset, size_t count, size_t& out_pos)
+	{
+		if (count == 0)
+			return 0;
+
+		size_t pos = position.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			// Nobody can claim cells past pos without moving position first, so if the CAS succeeds
+			// every cell seen ready is still ready and now ours.
+			size_t ready = 0;
+			intptr_t dif = 0;
+			for (; ready != count; ready += 1)
+			{
+				size_t seq =
+					buffer_[(pos + ready) & buffer_mask_].sequence_.load(std::memory_order_acquire);
+				dif = (intptr_t)seq - (intptr_t)(pos + ready + ready_offset);
+				if (dif != 0)
+					break;
+			}
+
+			if (ready != 0)
+			{
+				if (position.compare_exchange_weak
+				(pos, pos + ready, std::memory_order_relaxed))
+				{
+					out_pos = pos;
+					return ready;
+				}
+			}
+			else if (dif < 0)
+				return 0;
+			else
+				pos = position.load(std::memory_order_relaxed);
+		}
+	}
+
+	// The sequence of a claimed cell is its position, nobody else touches it until it is published.
+	void publish_enqueue(cell_t* cell)
+	{
+		size_t seq = cell->sequence_.load(std::memory_order_relaxed);
+		cell->sequence_.store(seq + 1, std::memory_order_release);
+		if constexpr (blocking)
+			notify(item_signal_, item_waiters_);
+	}
+
+	void publish_dequeue(cell_t* cell)
+	{
+		size_t seq = cell->sequence_.load(std::memory_order_relaxed);
+		cell->sequence_.store
+		(seq + buffer_mask_, std::memory_order_release);
+		if constexpr (blocking)
+			notify(space_signal_, space_waiters_);
+	}
+
+	// Either the sleeper's retry sees the change or the notifier sees the sleeper, the fences on
+	// both sides order the waiter count against the queue positions.
+	static void notify(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiters)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waiters.load(std::memory_order_relaxed) != 0)
+		{
+			signal.fetch_add(1, std::memory_order_release);
+			signal.notify_all();
+		}
+	}
+
+	template<typename F>
+	static void wait_until(const F& try_once, std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiters)
+	{
+		while (!try_once())
+		{
+			waiters.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			uint32_t observed = signal.load(std::memory_order_acquire);
+			if (try_once())
+			{
+				waiters.fetch_sub(1, std::memory_order_relaxed);
+				return;
+			}
+			signal.wait(observed, std::memory_order_relaxed);
+			waiters.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
 	static size_t const     cacheline_size = 64;
 	typedef char            cacheline_pad_t[cacheline_size];
 
@@ -100,7 +242,11 @@ private:
 	cacheline_pad_t         pad2_;
 	std::atomic<size_t>     dequeue_pos_;
 	cacheline_pad_t         pad3_;
+	std::atomic<uint32_t>   item_signal_{ 0 };
+	std::atomic<uint32_t>   item_waiters_{ 0 };
+	std::atomic<uint32_t>   space_signal_{ 0 };
+	std::atomic<uint32_t>   space_waiters_{ 0 };
 
 	mpmc_bounded_queue(mpmc_bounded_queue const&);
 	void operator = (mpmc_bounded_queue const&);
-};
\ No newline at end of file
+};
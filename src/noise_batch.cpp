@@ -0,0 +1,472 @@
+#include "noise_batch.hpp"
+
+#include <noise/module/perlin.h>
+#include <noise/module/select.h>
+#include <noise/module/add.h>
+#include <noise/module/multiply.h>
+#include <noise/module/scalebias.h>
+#include <noise/module/turbulence.h>
+#include <noise/interp.h>
+
+#include <tracy/Tracy.hpp>
+
+#include <emmintrin.h>
+
+#include <memory>
+#include <vector>
+
+namespace noise
+{
+// Defined by libnoise, including vectortable.h here would define it a second time.
+extern double g_randomVectors[256 * 4];
+}
+
+namespace noise_batch
+{
+
+// Gradient noise hash constants, must match libnoise's noisegen.cpp.
+constexpr int XNoiseGen = 1619;
+constexpr int YNoiseGen = 31337;
+constexpr int ZNoiseGen = 6971;
+constexpr int SeedNoiseGen = 1013;
+constexpr int ShiftNoiseGen = 8;
+
+struct PerlinParams
+{
+	double frequency;
+	double lacunarity;
+	double persistence;
+	int octaveCount;
+	int seed;
+	noise::NoiseQuality noiseQuality;
+};
+
+static __m128d linearInterp(__m128d n0, __m128d n1, __m128d a)
+{
+	return _mm_add_pd(_mm_mul_pd(_mm_sub_pd(_mm_set1_pd(1.0), a), n0), _mm_mul_pd(a, n1));
+}
+
+static __m128d sCurve3(__m128d a)
+{
+	return _mm_mul_pd(_mm_mul_pd(a, a), _mm_sub_pd(_mm_set1_pd(3.0), _mm_mul_pd(_mm_set1_pd(2.0), a)));
+}
+
+static __m128d sCurve5(__m128d a)
+{
+	const __m128d a3 = _mm_mul_pd(_mm_mul_pd(a, a), a);
+	const __m128d a4 = _mm_mul_pd(a3, a);
+	const __m128d a5 = _mm_mul_pd(a4, a);
+	return _mm_add_pd(_mm_sub_pd(_mm_mul_pd(_mm_set1_pd(6.0), a5), _mm_mul_pd(_mm_set1_pd(15.0), a4)), _mm_mul_pd(_mm_set1_pd(10.0), a3));
+}
+
+static __m128d makeInt32Range(__m128d n)
+{
+	const __m128d limit = _mm_set1_pd(1073741824.0);
+	const __m128d outOfRange = _mm_or_pd(_mm_cmpge_pd(n, limit), _mm_cmple_pd(n, _mm_sub_pd(_mm_setzero_pd(), limit)));
+
+	if (_mm_movemask_pd(outOfRange) == 0)
+	{
+		return n;
+	}
+
+	alignas(16) double lanes[2];
+	_mm_store_pd(lanes, n);
+	return _mm_set_pd(noise::MakeInt32Range(lanes[1]), noise::MakeInt32Range(lanes[0]));
+}
+
+// Matches libnoise's (x > 0.0 ? (int)x : (int)x - 1), which differs from floor() for negative integers.
+static __m128i cellOrigin(__m128d v)
+{
+	const __m128i truncated = _mm_cvttpd_epi32(v);
+	const __m128i notPositive = _mm_shuffle_epi32(_mm_castpd_si128(_mm_cmple_pd(v, _mm_setzero_pd())), _MM_SHUFFLE(3, 3, 2, 0));
+	return _mm_add_epi32(truncated, notPositive);
+}
+
+static __m128i mulloEpi32(__m128i a, __m128i b)
+{
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static __m128d gradientNoise(__m128d fx, __m128d fy, __m128d fz, __m128i ix, __m128i iy, __m128i iz, __m128i hash)
+{
+	__m128i vectorIndex = _mm_xor_si128(hash, _mm_srai_epi32(hash, ShiftNoiseGen));
+	vectorIndex = _mm_slli_epi32(_mm_and_si128(vectorIndex, _mm_set1_epi32(0xff)), 2);
+
+	// SSE2 has no gather, the table rows are fetched per lane.
+	const double* gradient0 = &noise::g_randomVectors[_mm_cvtsi128_si32(vectorIndex)];
+	const double* gradient1 = &noise::g_randomVectors[_mm_cvtsi128_si32(_mm_srli_si128(vectorIndex, 4))];
+
+	const __m128d xGradient = _mm_set_pd(gradient1[0], gradient0[0]);
+	const __m128d yGradient = _mm_set_pd(gradient1[1], gradient0[1]);
+	const __m128d zGradient = _mm_set_pd(gradient1[2], gradient0[2]);
+
+	const __m128d xPoint = _mm_sub_pd(fx, _mm_cvtepi32_pd(ix));
+	const __m128d yPoint = _mm_sub_pd(fy, _mm_cvtepi32_pd(iy));
+	const __m128d zPoint = _mm_sub_pd(fz, _mm_cvtepi32_pd(iz));
+
+	const __m128d dot = _mm_add_pd(_mm_add_pd(_mm_mul_pd(xGradient, xPoint), _mm_mul_pd(yGradient, yPoint)), _mm_mul_pd(zGradient, zPoint));
+	return _mm_mul_pd(dot, _mm_set1_pd(2.12));
+}
+
+static __m128d gradientCoherentNoise(__m128d x, __m128d y, __m128d z, int seed, noise::NoiseQuality noiseQuality)
+{
+	const __m128i one = _mm_set1_epi32(1);
+
+	const __m128i x0 = cellOrigin(x);
+	const __m128i y0 = cellOrigin(y);
+	const __m128i z0 = cellOrigin(z);
+	const __m128i x1 = _mm_add_epi32(x0, one);
+	const __m128i y1 = _mm_add_epi32(y0, one);
+	const __m128i z1 = _mm_add_epi32(z0, one);
+
+	__m128d xs = _mm_sub_pd(x, _mm_cvtepi32_pd(x0));
+	__m128d ys = _mm_sub_pd(y, _mm_cvtepi32_pd(y0));
+	__m128d zs = _mm_sub_pd(z, _mm_cvtepi32_pd(z0));
+
+	switch (noiseQuality)
+	{
+		case noise::QUALITY_FAST:
+			break;
+		case noise::QUALITY_STD:
+			xs = sCurve3(xs);
+			ys = sCurve3(ys);
+			zs = sCurve3(zs);
+			break;
+		case noise::QUALITY_BEST:
+			xs = sCurve5(xs);
+			ys = sCurve5(ys);
+			zs = sCurve5(zs);
+			break;
+	}
+
+	// The hash is linear in each coordinate, so neighbouring corners only differ by a constant.
+	const __m128i xHash = _mm_set1_epi32(XNoiseGen);
+	const __m128i yHash = _mm_set1_epi32(YNoiseGen);
+	const __m128i zHash = _mm_set1_epi32(ZNoiseGen);
+	const __m128i seedHash = _mm_set1_epi32((int)((uint32_t)SeedNoiseGen * (uint32_t)seed));
+
+	const __m128i h000 = _mm_add_epi32(
+		_mm_add_epi32(mulloEpi32(x0, xHash), mulloEpi32(y0, yHash)),
+		_mm_add_epi32(mulloEpi32(z0, zHash), seedHash));
+	const __m128i h100 = _mm_add_epi32(h000, xHash);
+	const __m128i h010 = _mm_add_epi32(h000, yHash);
+	const __m128i h110 = _mm_add_epi32(h010, xHash);
+	const __m128i h001 = _mm_add_epi32(h000, zHash);
+	const __m128i h101 = _mm_add_epi32(h001, xHash);
+	const __m128i h011 = _mm_add_epi32(h001, yHash);
+	const __m128i h111 = _mm_add_epi32(h011, xHash);
+
+	__m128d n0, n1, ix0, ix1, iy0, iy1;
+	n0 = gradientNoise(x, y, z, x0, y0, z0, h000);
+	n1 = gradientNoise(x, y, z, x1, y0, z0, h100);
+	ix0 = linearInterp(n0, n1, xs);
+	n0 = gradientNoise(x, y, z, x0, y1, z0, h010);
+	n1 = gradientNoise(x, y, z, x1, y1, z0, h110);
+	ix1 = linearInterp(n0, n1, xs);
+	iy0 = linearInterp(ix0, ix1, ys);
+	n0 = gradientNoise(x, y, z, x0, y0, z1, h001);
+	n1 = gradientNoise(x, y, z, x1, y0, z1, h101);
+	ix0 = linearInterp(n0, n1, xs);
+	n0 = gradientNoise(x, y, z, x0, y1, z1, h011);
+	n1 = gradientNoise(x, y, z, x1, y1, z1, h111);
+	ix1 = linearInterp(n0, n1, xs);
+	iy1 = linearInterp(ix0, ix1, ys);
+	return linearInterp(iy0, iy1, zs);
+}
+
+template<class Kernel>
+static void forEachPair(const double* x, const double* y, const double* z, double* values, size_t count, Kernel kernel)
+{
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		_mm_storeu_pd(values + i, kernel(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i), _mm_loadu_pd(z + i)));
+	}
+
+	if (i < count)
+	{
+		_mm_store_sd(values + i, kernel(_mm_set1_pd(x[i]), _mm_set1_pd(y[i]), _mm_set1_pd(z[i])));
+	}
+}
+
+static void getPerlinValues(const PerlinParams& params, const double* x, const double* y, const double* z, double* values, size_t count)
+{
+	const __m128d frequency = _mm_set1_pd(params.frequency);
+	const __m128d lacunarity = _mm_set1_pd(params.lacunarity);
+
+	forEachPair(x, y, z, values, count, [&](__m128d vx, __m128d vy, __m128d vz)
+	{
+		__m128d value = _mm_setzero_pd();
+		double curPersistence = 1.0;
+
+		vx = _mm_mul_pd(vx, frequency);
+		vy = _mm_mul_pd(vy, frequency);
+		vz = _mm_mul_pd(vz, frequency);
+
+		for (int curOctave = 0; curOctave < params.octaveCount; ++curOctave)
+		{
+			const int seed = params.seed + curOctave;
+			const __m128d signal = gradientCoherentNoise(makeInt32Range(vx), makeInt32Range(vy), makeInt32Range(vz), seed, params.noiseQuality);
+			value = _mm_add_pd(value, _mm_mul_pd(signal, _mm_set1_pd(curPersistence)));
+
+			vx = _mm_mul_pd(vx, lacunarity);
+			vy = _mm_mul_pd(vy, lacunarity);
+			vz = _mm_mul_pd(vz, lacunarity);
+			curPersistence *= params.persistence;
+		}
+
+		return value;
+	});
+}
+
+static void getTurbulenceValues(const noise::module::Turbulence& turbulence, const double* x, const double* y, const double* z, double* values, size_t count)
+{
+	// The distortion modules are private, but are plain Perlin modules set up from these parameters.
+	PerlinParams params{};
+	params.frequency = turbulence.GetFrequency();
+	params.lacunarity = noise::module::DEFAULT_PERLIN_LACUNARITY;
+	params.persistence = noise::module::DEFAULT_PERLIN_PERSISTENCE;
+	params.octaveCount = turbulence.GetRoughnessCount();
+	params.noiseQuality = noise::module::DEFAULT_PERLIN_QUALITY;
+
+	const double power = turbulence.GetPower();
+	const int seed = turbulence.GetSeed();
+
+	static const double offsets[3][3] = {
+		{ 12414.0 / 65536.0, 65124.0 / 65536.0, 31337.0 / 65536.0 },
+		{ 26519.0 / 65536.0, 18128.0 / 65536.0, 60493.0 / 65536.0 },
+		{ 53820.0 / 65536.0, 11213.0 / 65536.0, 44845.0 / 65536.0 },
+	};
+
+	std::unique_ptr<double[]> offsetX(new double[count]);
+	std::unique_ptr<double[]> offsetY(new double[count]);
+	std::unique_ptr<double[]> offsetZ(new double[count]);
+	std::unique_ptr<double[]> distortion(new double[count]);
+
+	const double* coords[3] = { x, y, z };
+	std::unique_ptr<double[]> distorted[3];
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			offsetX[i] = x[i] + offsets[axis][0];
+			offsetY[i] = y[i] + offsets[axis][1];
+			offsetZ[i] = z[i] + offsets[axis][2];
+		}
+
+		params.seed = seed + axis;
+		getPerlinValues(params, offsetX.get(), offsetY.get(), offsetZ.get(), distortion.get(), count);
+
+		distorted[axis].reset(new double[count]);
+		for (size_t i = 0; i < count; ++i)
+		{
+			distorted[axis][i] = coords[axis][i] + (distortion[i] * power);
+		}
+	}
+
+	getValues(turbulence.GetSourceModule(0), distorted[0].get(), distorted[1].get(), distorted[2].get(), values, count);
+}
+
+// Evaluates the module only at the given indices, values at other indices are left alone.
+static void getValuesAt(const noise::module::Module& module, const double* x, const double* y, const double* z, const std::vector<size_t>& indices, double* values, size_t count)
+{
+	if (indices.size() == count)
+	{
+		getValues(module, x, y, z, values, count);
+		return;
+	}
+
+	if (indices.empty())
+	{
+		return;
+	}
+
+	const size_t indexCount = indices.size();
+	std::unique_ptr<double[]> gatheredX(new double[indexCount]);
+	std::unique_ptr<double[]> gatheredY(new double[indexCount]);
+	std::unique_ptr<double[]> gatheredZ(new double[indexCount]);
+	std::unique_ptr<double[]> gatheredValues(new double[indexCount]);
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		gatheredX[i] = x[indices[i]];
+		gatheredY[i] = y[indices[i]];
+		gatheredZ[i] = z[indices[i]];
+	}
+
+	getValues(module, gatheredX.get(), gatheredY.get(), gatheredZ.get(), gatheredValues.get(), indexCount);
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		values[indices[i]] = gatheredValues[i];
+	}
+}
+
+static void getSelectValues(const noise::module::Select& select, const double* x, const double* y, const double* z, double* values, size_t count)
+{
+	std::unique_ptr<double[]> control(new double[count]);
+	std::unique_ptr<double[]> source0(new double[count]);
+	std::unique_ptr<double[]> source1(new double[count]);
+
+	getValues(select.GetControlModule(), x, y, z, control.get(), count);
+
+	const double lowerBound = select.GetLowerBound();
+	const double upperBound = select.GetUpperBound();
+	const double edgeFalloff = select.GetEdgeFalloff();
+
+	// Like GetValue, only evaluate the sources the control value picks, both of them inside a falloff band.
+	std::vector<size_t> source0Indices;
+	std::vector<size_t> source1Indices;
+	source0Indices.reserve(count);
+	source1Indices.reserve(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double controlValue = control[i];
+
+		bool needsSource0;
+		bool needsSource1;
+		if (edgeFalloff > 0.0)
+		{
+			const bool inLowerFalloff = controlValue >= (lowerBound - edgeFalloff) && controlValue < (lowerBound + edgeFalloff);
+			const bool inUpperFalloff = controlValue >= (upperBound - edgeFalloff) && controlValue < (upperBound + edgeFalloff);
+			const bool inside = controlValue >= (lowerBound + edgeFalloff) && controlValue < (upperBound - edgeFalloff);
+			needsSource0 = inLowerFalloff || inUpperFalloff || !inside;
+			needsSource1 = inLowerFalloff || inUpperFalloff || inside;
+		}
+		else
+		{
+			needsSource1 = !(controlValue < lowerBound || controlValue > upperBound);
+			needsSource0 = !needsSource1;
+		}
+
+		if (needsSource0)
+		{
+			source0Indices.push_back(i);
+		}
+
+		if (needsSource1)
+		{
+			source1Indices.push_back(i);
+		}
+	}
+
+	getValuesAt(select.GetSourceModule(0), x, y, z, source0Indices, source0.get(), count);
+	getValuesAt(select.GetSourceModule(1), x, y, z, source1Indices, source1.get(), count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double controlValue = control[i];
+
+		if (edgeFalloff > 0.0)
+		{
+			if (controlValue < (lowerBound - edgeFalloff))
+			{
+				values[i] = source0[i];
+			}
+			else if (controlValue < (lowerBound + edgeFalloff))
+			{
+				const double lowerCurve = (lowerBound - edgeFalloff);
+				const double upperCurve = (lowerBound + edgeFalloff);
+				const double alpha = noise::SCurve3((controlValue - lowerCurve) / (upperCurve - lowerCurve));
+				values[i] = noise::LinearInterp(source0[i], source1[i], alpha);
+			}
+			else if (controlValue < (upperBound - edgeFalloff))
+			{
+				values[i] = source1[i];
+			}
+			else if (controlValue < (upperBound + edgeFalloff))
+			{
+				const double lowerCurve = (upperBound - edgeFalloff);
+				const double upperCurve = (upperBound + edgeFalloff);
+				const double alpha = noise::SCurve3((controlValue - lowerCurve) / (upperCurve - lowerCurve));
+				values[i] = noise::LinearInterp(source1[i], source0[i], alpha);
+			}
+			else
+			{
+				values[i] = source0[i];
+			}
+		}
+		else
+		{
+			values[i] = (controlValue < lowerBound || controlValue > upperBound) ? source0[i] : source1[i];
+		}
+	}
+}
+
+void getValues(
+	const noise::module::Module& module,
+	const double* x,
+	const double* y,
+	const double* z,
+	double* values,
+	size_t count)
+{
+	ZoneScoped;
+
+	if (const auto* perlin = dynamic_cast<const noise::module::Perlin*>(&module))
+	{
+		PerlinParams params{};
+		params.frequency = perlin->GetFrequency();
+		params.lacunarity = perlin->GetLacunarity();
+		params.persistence = perlin->GetPersistence();
+		params.octaveCount = perlin->GetOctaveCount();
+		params.seed = perlin->GetSeed();
+		params.noiseQuality = perlin->GetNoiseQuality();
+
+		getPerlinValues(params, x, y, z, values, count);
+	}
+	else if (const auto* select = dynamic_cast<const noise::module::Select*>(&module))
+	{
+		getSelectValues(*select, x, y, z, values, count);
+	}
+	else if (const auto* add = dynamic_cast<const noise::module::Add*>(&module))
+	{
+		std::unique_ptr<double[]> rhs(new double[count]);
+		getValues(add->GetSourceModule(0), x, y, z, values, count);
+		getValues(add->GetSourceModule(1), x, y, z, rhs.get(), count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] += rhs[i];
+		}
+	}
+	else if (const auto* multiply = dynamic_cast<const noise::module::Multiply*>(&module))
+	{
+		std::unique_ptr<double[]> rhs(new double[count]);
+		getValues(multiply->GetSourceModule(0), x, y, z, values, count);
+		getValues(multiply->GetSourceModule(1), x, y, z, rhs.get(), count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] *= rhs[i];
+		}
+	}
+	else if (const auto* scaleBias = dynamic_cast<const noise::module::ScaleBias*>(&module))
+	{
+		getValues(scaleBias->GetSourceModule(0), x, y, z, values, count);
+
+		const double scale = scaleBias->GetScale();
+		const double bias = scaleBias->GetBias();
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] = values[i] * scale + bias;
+		}
+	}
+	else if (const auto* turbulence = dynamic_cast<const noise::module::Turbulence*>(&module))
+	{
+		getTurbulenceValues(*turbulence, x, y, z, values, count);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] = module.GetValue(x[i], y[i], z[i]);
+		}
+	}
+}
+
+}
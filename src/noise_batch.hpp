@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+namespace noise
+{
+namespace module
+{
+class Module;
+}
+}
+
+namespace noise_batch
+{
+
+// Evaluates a libnoise module graph for a batch of SoA coordinates. Perlin, Select, Add, Multiply,
+// ScaleBias and Turbulence are evaluated a whole batch at a time with SSE2, in the same operation order
+// as their GetValue() so results match. Any other module falls back to calling GetValue() per point.
+void getValues(
+	const noise::module::Module& module,
+	const double* x,
+	const double* y,
+	const double* z,
+	double* values,
+	size_t count);
+
+}
@@ -0,0 +1,165 @@
+#include "noise_batch_benchmark.hpp"
+#include "noise_batch.hpp"
+#include "terrain.hpp"
+
+#include <noise/module/perlin.h>
+#include <noise/module/select.h>
+#include <noise/module/add.h>
+#include <noise/module/multiply.h>
+#include <noise/module/scalebias.h>
+#include <noise/module/turbulence.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <memory>
+#include <random>
+
+constexpr int BenchmarkSeed = 1337;
+constexpr size_t BenchmarkPointCount = 1 << 16;
+constexpr int BenchmarkRunCount = 3;
+
+// Most points are around the world origin, every 16th is far enough out for MakeInt32Range to wrap it.
+constexpr double BenchmarkNearRange = 8192.0;
+constexpr double BenchmarkFarRange = 1e11;
+
+struct BenchmarkPoints
+{
+	std::unique_ptr<double[]> x;
+	std::unique_ptr<double[]> y;
+	std::unique_ptr<double[]> z;
+};
+
+template<class Evaluate>
+static double bestRate(const Evaluate& evaluate)
+{
+	double bestTime = 1e9;
+	for (int run = 0; run < BenchmarkRunCount; ++run)
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		evaluate();
+		const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+		bestTime = elapsed.count() < bestTime ? elapsed.count() : bestTime;
+	}
+
+	return (double)BenchmarkPointCount / bestTime;
+}
+
+template<class GetValue, class GetValues>
+static bool benchmarkModule(const char* name, const BenchmarkPoints& points, const GetValue& getValue, const GetValues& getValues)
+{
+	std::unique_ptr<double[]> reference(new double[BenchmarkPointCount]);
+	std::unique_ptr<double[]> batched(new double[BenchmarkPointCount]);
+
+	const double singleRate = bestRate([&]() {
+		for (size_t i = 0; i < BenchmarkPointCount; ++i)
+		{
+			reference[i] = getValue(points.x[i], points.y[i], points.z[i]);
+		}
+	});
+
+	const double batchRate = bestRate([&]() {
+		getValues(points.x.get(), points.y.get(), points.z.get(), batched.get(), BenchmarkPointCount);
+	});
+
+	// The batch follows GetValue's operation order, anything but an exact match is a bug.
+	size_t mismatchCount = 0;
+	double maxError = 0.0;
+	for (size_t i = 0; i < BenchmarkPointCount; ++i)
+	{
+		if (batched[i] != reference[i])
+		{
+			++mismatchCount;
+			maxError = std::max(maxError, std::abs(batched[i] - reference[i]));
+		}
+	}
+
+	printf("%-12s %8.2f M points/s single %8.2f M points/s batched %6.2fx, %zu mismatches, max error %g\n", 
+		name, 
+		singleRate / 1e6, 
+		batchRate / 1e6, 
+		batchRate / singleRate, 
+		mismatchCount, 
+		maxError);
+
+	return mismatchCount == 0;
+}
+
+static bool benchmarkModule(const char* name, const BenchmarkPoints& points, const noise::module::Module& module)
+{
+	return benchmarkModule(name, points, 
+		[&module](double x, double y, double z) { return module.GetValue(x, y, z); }, 
+		[&module](const double* x, const double* y, const double* z, double* values, size_t count) { noise_batch::getValues(module, x, y, z, values, count); });
+}
+
+void runNoiseBatchBenchmark()
+{
+	std::mt19937 random(BenchmarkSeed);
+	std::uniform_real_distribution<double> nearDistribution(-BenchmarkNearRange, BenchmarkNearRange);
+	std::uniform_real_distribution<double> farDistribution(-BenchmarkFarRange, BenchmarkFarRange);
+
+	BenchmarkPoints points;
+	points.x.reset(new double[BenchmarkPointCount]);
+	points.y.reset(new double[BenchmarkPointCount]);
+	points.z.reset(new double[BenchmarkPointCount]);
+	for (size_t i = 0; i < BenchmarkPointCount; ++i)
+	{
+		std::uniform_real_distribution<double>& distribution = (i % 16) == 15 ? farDistribution : nearDistribution;
+		points.x[i] = distribution(random);
+		points.y[i] = distribution(random);
+		points.z[i] = distribution(random);
+	}
+
+	noise::module::Perlin perlin;
+	perlin.SetSeed(BenchmarkSeed);
+	perlin.SetFrequency(0.0176);
+
+	noise::module::Perlin perlinBest;
+	perlinBest.SetSeed(BenchmarkSeed + 1);
+	perlinBest.SetFrequency(0.0032);
+	perlinBest.SetOctaveCount(4);
+	perlinBest.SetNoiseQuality(noise::QUALITY_BEST);
+
+	noise::module::Select select;
+	select.SetSourceModule(0, perlin);
+	select.SetSourceModule(1, perlinBest);
+	select.SetControlModule(perlinBest);
+	select.SetBounds(-0.25, 0.5);
+	select.SetEdgeFalloff(0.125);
+
+	noise::module::Add add;
+	add.SetSourceModule(0, perlin);
+	add.SetSourceModule(1, perlinBest);
+
+	noise::module::Multiply multiply;
+	multiply.SetSourceModule(0, perlin);
+	multiply.SetSourceModule(1, perlinBest);
+
+	noise::module::ScaleBias scaleBias;
+	scaleBias.SetSourceModule(0, perlin);
+	scaleBias.SetScale(0.5);
+	scaleBias.SetBias(-0.25);
+
+	noise::module::Turbulence turbulence;
+	turbulence.SetSourceModule(0, perlin);
+	turbulence.SetSeed(BenchmarkSeed + 2);
+	turbulence.SetFrequency(0.05);
+	turbulence.SetPower(4.0);
+
+	Terrain::init(BenchmarkSeed);
+
+	bool matches = true;
+	matches &= benchmarkModule("perlin", points, perlin);
+	matches &= benchmarkModule("perlin best", points, perlinBest);
+	matches &= benchmarkModule("select", points, select);
+	matches &= benchmarkModule("add", points, add);
+	matches &= benchmarkModule("multiply", points, multiply);
+	matches &= benchmarkModule("scale bias", points, scaleBias);
+	matches &= benchmarkModule("turbulence", points, turbulence);
+	matches &= benchmarkModule("terrain", points, 
+		[](double x, double y, double z) { return Terrain::surface(x, y, z); }, 
+		[](const double* x, const double* y, const double* z, double* values, size_t count) { Terrain::surface(x, y, z, values, count); });
+
+	printf("%s\n", matches ? "batched values match GetValue" : "batched values differ from GetValue");
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Checks noise_batch::getValues against GetValue() at random points for every module it batches and for
+// the terrain's libnoise recipe, then prints the throughput of both. Run with -batchbench.
+void runNoiseBatchBenchmark();
@@ -0,0 +1,98 @@
+#include "noise_benchmark.hpp"
+#include "terrain.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+constexpr int BenchmarkSeed = 1337;
+constexpr int32_t BenchmarkBlockSize = 33;
+constexpr int32_t BenchmarkSideBlocks = 8;
+constexpr int BenchmarkRunCount = 3;
+
+// Measured as the sum of its octave bands, see Terrain::LayerCount.
+constexpr int DetailLayer = 2;
+
+static double sampleBlocks(float* values)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Unaligned starts on purpose, slabs start anywhere on the lattice.
+	for (int32_t z = 0; z < BenchmarkSideBlocks; ++z)
+	{
+		for (int32_t x = 0; x < BenchmarkSideBlocks; ++x)
+		{
+			Terrain::sample(values, (x * 32) + 3, -64, (z * 32) - 5, BenchmarkBlockSize, BenchmarkBlockSize, BenchmarkBlockSize, 1.0f);
+		}
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	return elapsed.count();
+}
+
+static double bestSampleTime(float* values)
+{
+	// The first run pays for page faults and cold caches.
+	sampleBlocks(values);
+
+	double bestTime = 1e9;
+	for (int run = 0; run < BenchmarkRunCount; ++run)
+	{
+		const double time = sampleBlocks(values);
+		bestTime = time < bestTime ? time : bestTime;
+	}
+
+	return bestTime;
+}
+
+void runNoiseBenchmark()
+{
+	Terrain::init(BenchmarkSeed);
+
+	int sampleScales[Terrain::LayerCount];
+	for (int layer = 0; layer < Terrain::LayerCount; ++layer)
+	{
+		sampleScales[layer] = Terrain::getLayerSampleScale(layer);
+	}
+
+	for (int layer = 0; layer < Terrain::LayerCount; ++layer)
+	{
+		if (sampleScales[layer] == 0 && layer != DetailLayer)
+		{
+			continue;
+		}
+
+		float maxError;
+		float meanError;
+		Terrain::measureSampleError(layer, 3, -64, -5, BenchmarkBlockSize * 2, BenchmarkBlockSize, BenchmarkBlockSize * 2, &maxError, &meanError);
+
+		if (layer == DetailLayer)
+		{
+			printf("layer %d, octave bands: max error %.5f, mean error %.5f\n", layer, maxError, meanError);
+		}
+		else
+		{
+			printf("layer %d, sample scale %d: max error %.5f, mean error %.5f\n", layer, sampleScales[layer], maxError, meanError);
+		}
+	}
+
+	std::unique_ptr<float[]> values(new float[BenchmarkBlockSize * BenchmarkBlockSize * BenchmarkBlockSize]);
+	const double blockCount = (double)(BenchmarkSideBlocks * BenchmarkSideBlocks);
+
+	const double sampledTime = bestSampleTime(values.get());
+
+	for (int layer = 0; layer < Terrain::LayerCount; ++layer)
+	{
+		Terrain::setLayerSampleScale(layer, 0);
+	}
+
+	const double fullTime = bestSampleTime(values.get());
+
+	for (int layer = 0; layer < Terrain::LayerCount; ++layer)
+	{
+		Terrain::setLayerSampleScale(layer, sampleScales[layer]);
+	}
+
+	printf("full evaluation %8.3f ms/chunk\n", fullTime * 1000.0 / blockCount);
+	printf("coarse sampling %8.3f ms/chunk, %.2fx\n", sampledTime * 1000.0 / blockCount, fullTime / sampledTime);
+}
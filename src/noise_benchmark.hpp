@@ -0,0 +1,5 @@
+#pragma once
+
+// Measures the error coarse lattice sampling adds to each terrain noise layer and how much time it saves 
+// on full resolution chunks, no window or GPU needed. Run with -noisebench.
+void runNoiseBenchmark();
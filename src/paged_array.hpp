@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+// An array allocated a page at a time. Elements never move once their page exists, so references 
+// stay valid while it grows, and memory follows the number of elements in use rather than a maximum
+// decided up front.
+template<class T, size_t PageSize = 4096>
+class PagedArray
+{
+	static_assert((PageSize & (PageSize - 1)) == 0, "the page size must be a power of two");
+
+public:
+	T& operator[](size_t index) { return m_pages[index / PageSize][index % PageSize]; }
+	const T& operator[](size_t index) const { return m_pages[index / PageSize][index % PageSize]; }
+
+	size_t capacity() const { return m_pages.size() * PageSize; }
+
+	// Allocates pages until there is room for count elements.
+	void reserve(size_t count)
+	{
+		while (capacity() < count)
+		{
+			m_pages.emplace_back(new T[PageSize]);
+		}
+	}
+
+	// Frees the pages past the ones needed for count elements, all but one spare so a count going 
+	// back and forth over a page boundary doesn't allocate every time.
+	void trim(size_t count)
+	{
+		const size_t keepCount = (count + PageSize - 1) / PageSize + 1;
+		while (m_pages.size() > keepCount)
+		{
+			m_pages.pop_back();
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<T[]>> m_pages;
+};
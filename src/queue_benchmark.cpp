@@ -0,0 +1,169 @@
+#include "queue_benchmark.hpp"
+
+#include <mpmc_bounded_queue.hpp>
+#include <spsc_bounded_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+constexpr size_t QueueBenchmarkCapacity = 4096;
+constexpr size_t QueueBenchmarkItemCount = 1 << 20;
+constexpr size_t QueueBenchmarkBatchSize = 16;
+constexpr int QueueBenchmarkRunCount = 3;
+
+// About the size of World::WorkItem.
+struct QueueBenchmarkItem
+{
+	uint64_t sequence;
+	uint64_t payload[9];
+};
+
+enum class QueueBenchmarkMode
+{
+	Single,
+	Batch,
+	Blocking,
+	Spsc,
+};
+
+static const char* const QueueBenchmarkModeNames[] = {
+	"mpmc, single",
+	"mpmc, batch",
+	"mpmc, blocking",
+	"spsc",
+};
+
+template<QueueBenchmarkMode mode, typename Queue>
+static void produce(Queue& queue, size_t itemCount)
+{
+	QueueBenchmarkItem items[QueueBenchmarkBatchSize] = {};
+
+	for (size_t sent = 0; sent < itemCount;)
+	{
+		size_t enqueued;
+		if constexpr (mode == QueueBenchmarkMode::Blocking)
+		{
+			queue.wait_enqueue(items[0]);
+			enqueued = 1;
+		}
+		else if constexpr (mode == QueueBenchmarkMode::Batch)
+		{
+			const size_t count = itemCount - sent < QueueBenchmarkBatchSize ? itemCount - sent : QueueBenchmarkBatchSize;
+			enqueued = queue.enqueue_n(items, count);
+		}
+		else
+		{
+			enqueued = queue.enqueue(items[0]) ? 1 : 0;
+		}
+
+		if (enqueued == 0)
+		{
+			std::this_thread::yield();
+		}
+		sent += enqueued;
+	}
+}
+
+template<QueueBenchmarkMode mode, typename Queue>
+static void consume(Queue& queue, size_t itemCount)
+{
+	QueueBenchmarkItem items[QueueBenchmarkBatchSize];
+
+	for (size_t received = 0; received < itemCount;)
+	{
+		size_t dequeued;
+		if constexpr (mode == QueueBenchmarkMode::Blocking)
+		{
+			queue.wait_dequeue(items[0]);
+			dequeued = 1;
+		}
+		else if constexpr (mode == QueueBenchmarkMode::Batch)
+		{
+			dequeued = queue.dequeue_n(items, QueueBenchmarkBatchSize);
+		}
+		else
+		{
+			dequeued = queue.dequeue(items[0]) ? 1 : 0;
+		}
+
+		if (dequeued == 0)
+		{
+			std::this_thread::yield();
+		}
+		received += dequeued;
+	}
+}
+
+template<QueueBenchmarkMode mode, typename Queue>
+static double runQueue(size_t producerCount)
+{
+	Queue queue(QueueBenchmarkCapacity);
+
+	std::atomic<bool> start{ false };
+	std::vector<std::thread> producers;
+
+	const size_t itemsPerProducer = QueueBenchmarkItemCount / producerCount;
+	for (size_t i = 0; i < producerCount; ++i)
+	{
+		producers.push_back(std::thread([&queue, &start, itemsPerProducer]() {
+			while (!start.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+			produce<mode>(queue, itemsPerProducer);
+		}));
+	}
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	start.store(true, std::memory_order_release);
+
+	// The consumer is the calling thread, like the main thread draining the work queue.
+	consume<mode>(queue, itemsPerProducer * producerCount);
+
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	for (std::thread& producer : producers)
+	{
+		producer.join();
+	}
+
+	return (double)(itemsPerProducer * producerCount) / elapsed.count();
+}
+
+template<QueueBenchmarkMode mode, typename Queue>
+static void benchmarkQueue(size_t producerCount)
+{
+	double bestRate = 0.0;
+	for (int run = 0; run < QueueBenchmarkRunCount; ++run)
+	{
+		const double rate = runQueue<mode, Queue>(producerCount);
+		bestRate = rate > bestRate ? rate : bestRate;
+	}
+
+	printf("%-16s %2zu producers %8.2f M items/s\n", 
+		QueueBenchmarkModeNames[(int)mode], 
+		producerCount, 
+		bestRate / 1e6);
+}
+
+void runQueueBenchmark()
+{
+	printf("%zu byte items, %zu item queues, batches of %zu\n", 
+		sizeof(QueueBenchmarkItem), 
+		QueueBenchmarkCapacity, 
+		QueueBenchmarkBatchSize);
+
+	// Single item operations are the queue as it was before batching, the baseline for the others.
+	for (size_t producerCount = 1; producerCount <= 32; producerCount *= 2)
+	{
+		benchmarkQueue<QueueBenchmarkMode::Single, mpmc_bounded_queue<QueueBenchmarkItem>>(producerCount);
+		benchmarkQueue<QueueBenchmarkMode::Batch, mpmc_bounded_queue<QueueBenchmarkItem>>(producerCount);
+		benchmarkQueue<QueueBenchmarkMode::Blocking, mpmc_bounded_queue<QueueBenchmarkItem, true>>(producerCount);
+	}
+
+	benchmarkQueue<QueueBenchmarkMode::Spsc, spsc_bounded_queue<QueueBenchmarkItem>>(1);
+}
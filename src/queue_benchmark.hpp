@@ -0,0 +1,6 @@
+#pragma once
+
+// Pushes work item sized payloads from 1 to 32 producer threads into one consumer through
+// mpmc_bounded_queue, one item at a time, in batches and with blocking waits, and through
+// spsc_bounded_queue for the single producer case. Prints the throughput of each. Run with -queuebench.
+void runQueueBenchmark();
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Single producer, single consumer counterpart of mpmc_bounded_queue, for channels with one thread on
+// each end. No CAS and no per cell sequence, each side caches the other side's position and only
+// reloads it when the queue looks full or empty.
+template<typename T>
+class spsc_bounded_queue
+{
+public:
+	spsc_bounded_queue(size_t buffer_size)
+		: buffer_(new T[buffer_size])
+		, buffer_mask_(buffer_size - 1)
+	{
+		assert((buffer_size >= 2) &&
+			((buffer_size & (buffer_size - 1)) == 0));
+		enqueue_pos_.store(0, std::memory_order_relaxed);
+		dequeue_pos_.store(0, std::memory_order_relaxed);
+	}
+
+	~spsc_bounded_queue()
+	{
+		delete[] buffer_;
+	}
+
+	bool enqueue(T const& data)
+	{
+		T* slot = claim_enqueue();
+		if (!slot)
+			return false;
+		*slot = data;
+		publish_enqueue();
+		return true;
+	}
+
+	bool enqueue(T&& data)
+	{
+		T* slot = claim_enqueue();
+		if (!slot)
+			return false;
+		*slot = std::move(data);
+		publish_enqueue();
+		return true;
+	}
+
+	// Like mpmc_bounded_queue::emplace, constructs the item in place of the slot's old value.
+	template<typename... Args>
+	bool emplace(Args&&... args)
+	{
+		static_assert(std::is_nothrow_constructible_v<T, Args&&...>, "a throwing constructor would leave the slot empty");
+		T* slot = claim_enqueue();
+		if (!slot)
+			return false;
+		std::destroy_at(slot);
+		std::construct_at(slot, std::forward<Args>(args)...);
+		publish_enqueue();
+		return true;
+	}
+
+	bool dequeue(T& data)
+	{
+		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		if (pos == cached_enqueue_pos_)
+		{
+			cached_enqueue_pos_ = enqueue_pos_.load(std::memory_order_acquire);
+			if (pos == cached_enqueue_pos_)
+				return false;
+		}
+		data = std::move(buffer_[pos & buffer_mask_]);
+		dequeue_pos_.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t unsafe_size() const
+	{
+		return enqueue_pos_ - dequeue_pos_;
+	}
+
+private:
+	T* claim_enqueue()
+	{
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		if (pos - cached_dequeue_pos_ > buffer_mask_)
+		{
+			cached_dequeue_pos_ = dequeue_pos_.load(std::memory_order_acquire);
+			if (pos - cached_dequeue_pos_ > buffer_mask_)
+				return nullptr;
+		}
+		return &buffer_[pos & buffer_mask_];
+	}
+
+	void publish_enqueue()
+	{
+		enqueue_pos_.store(enqueue_pos_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	static size_t const     cacheline_size = 64;
+	typedef char            cacheline_pad_t[cacheline_size];
+
+	cacheline_pad_t         pad0_;
+	T* const                buffer_;
+	size_t const            buffer_mask_;
+	cacheline_pad_t         pad1_;
+	// Written by the producer.
+	std::atomic<size_t>     enqueue_pos_;
+	size_t                  cached_dequeue_pos_ = 0;
+	cacheline_pad_t         pad2_;
+	// Written by the consumer.
+	std::atomic<size_t>     dequeue_pos_;
+	size_t                  cached_enqueue_pos_ = 0;
+	cacheline_pad_t         pad3_;
+
+	spsc_bounded_queue(spsc_bounded_queue const&);
+	void operator = (spsc_bounded_queue const&);
+};
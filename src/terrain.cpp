@@ -1,6 +1,9 @@
 #include "terrain.hpp"
+#include "noise_batch.hpp"
 
 #include <noise/module/perlin.h>
+#include <noise/module/select.h>
+#include <noise/module/turbulence.h>
 
 #include <FastNoiseSIMD/FastNoiseSIMD.h>
 
@@ -8,50 +11,512 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
+#include <cassert>
+#include <cmath>
 
-//static noise::module::Perlin A;
+// libnoise recipe, B is churned by turbulence wherever the low frequency A is above zero.
+static noise::module::Perlin A;
 static noise::module::Perlin B;
+static noise::module::Turbulence C;
+static noise::module::Select surfaceRecipe;
 
-static std::unique_ptr<FastNoiseSIMD> fastNoise;
-static std::unique_ptr<FastNoiseSIMD> fastNoise2;
-static std::unique_ptr<FastNoiseSIMD> fastNoise3;
-static std::unique_ptr<FastNoiseSIMD> fastNoise4;
-static std::unique_ptr<FastNoiseSIMD> fastNoise5;
+static bool libnoiseRecipeEnabled = false;
 
-void Terrain::init(int seed)
+typedef std::unique_ptr<FastNoiseSIMD> NoiseLayers[Terrain::LayerCount];
+
+static NoiseLayers layers;
+
+// log2 of the lattice spacing each layer is evaluated at.
+static int layerSampleScales[Terrain::LayerCount] = {
+	0,
+	1,
+	0,
+	0,
+	2,
+	2,
+	1,
+	0,
+};
+
+// The detail layer's octaves, split into bands so the smooth low octaves can be evaluated on a coarse 
+// lattice. Each band is a fractal of its own starting at the band's first octave.
+struct OctaveBand
+{
+	int layer;
+	int firstOctave;
+	int octaveCount;
+};
+
+constexpr int DetailLayer = 2;
+constexpr int DetailOctaveCount = 10;
+constexpr float DetailFrequency = 0.0025f;
+constexpr float DetailGain = 0.5f;
+
+static const OctaveBand detailBands[] = {
+	{ 5, 0, 5 },
+	{ 6, 5, 2 },
+	{ 7, 7, 3 },
+};
+
+// Height layer recipe: density is the depth below a 2D height field, perturbed by 3D detail.
+// The surface is therefore always within HeightDetailAmplitude of the height field.
+constexpr float HeightAmplitude = 96.0f;
+constexpr float HeightDetailAmplitude = 24.0f;
+constexpr float HeightBoundsMargin = 1.1f;
+
+static bool heightLayerEnabled = false;
+
+// Domain warp, a low frequency displacement field evaluated on a coarse lattice and trilinearly 
+// interpolated per sample. The lattice is cached in tiles spanning several chunks so neighbours share it.
+constexpr int32_t WarpCellSize = 8;
+constexpr int32_t WarpTileSize = 16;
+constexpr int32_t WarpTilePointCount = WarpTileSize * WarpTileSize * WarpTileSize;
+constexpr size_t WarpTileCacheSize = 256;
+
+struct WarpTile
+{
+	int32_t tx;
+	int32_t ty;
+	int32_t tz;
+	// x, y and z displacement sets back to back, laid out like noise sets.
+	std::unique_ptr<float[]> displacement;
+};
+
+static std::unique_ptr<FastNoiseSIMD> warpNoise[3];
+static float warpAmplitude = 0.0f;
+
+static std::mutex warpTileCacheMutex;
+static std::shared_ptr<const WarpTile> warpTileCache[WarpTileCacheSize];
+
+static int32_t floorDiv(int32_t a, int32_t b)
+{
+	return (a / b) - ((a % b) < 0 ? 1 : 0);
+}
+
+static std::shared_ptr<const WarpTile> getWarpTile(int32_t tx, int32_t ty, int32_t tz)
+{
+	const size_t slot = ((uint32_t)tx * 73856093u ^ (uint32_t)ty * 19349663u ^ (uint32_t)tz * 83492791u) % WarpTileCacheSize;
+
+	{
+		std::lock_guard<std::mutex> lock(warpTileCacheMutex);
+		const std::shared_ptr<const WarpTile>& cached = warpTileCache[slot];
+		if (cached && cached->tx == tx && cached->ty == ty && cached->tz == tz)
+		{
+			return cached;
+		}
+	}
+
+	std::shared_ptr<WarpTile> tile(new WarpTile);
+	tile->tx = tx;
+	tile->ty = ty;
+	tile->tz = tz;
+	tile->displacement.reset(new float[WarpTilePointCount * 3]);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float* noiseSet = warpNoise[axis]->GetNoiseSet(
+			tx * WarpTileSize, 
+			ty * WarpTileSize, 
+			tz * WarpTileSize, 
+			WarpTileSize, 
+			WarpTileSize, 
+			WarpTileSize, 
+			(float)WarpCellSize);
+
+		float* displacement = tile->displacement.get() + (axis * WarpTilePointCount);
+		for (int i = 0; i < WarpTilePointCount; ++i)
+		{
+			displacement[i] = noiseSet[i] * warpAmplitude;
+		}
+
+		FastNoiseSIMD::FreeNoiseSet(noiseSet);
+	}
+
+	std::lock_guard<std::mutex> lock(warpTileCacheMutex);
+	warpTileCache[slot] = tile;
+	return tile;
+}
+
+// Writes the warped world space position of every sample into outVectorSet. Positions are absolute 
+// rather than relative to a vector set offset, the extra rounding of the offset would make neighbouring 
+// chunks disagree on their shared samples.
+static void buildWarpedLattice(
+	FastNoiseVectorSet* outVectorSet,
+	int32_t x,
+	int32_t y,
+	int32_t z,
+	int32_t x1,
+	int32_t y1,
+	int32_t z1,
+	float scale)
+{
+	// Warp lattice points covering the set, in world units.
+	const int32_t px0 = floorDiv((int32_t)std::floor(x * scale), WarpCellSize);
+	const int32_t py0 = floorDiv((int32_t)std::floor(y * scale), WarpCellSize);
+	const int32_t pz0 = floorDiv((int32_t)std::floor(z * scale), WarpCellSize);
+	const int32_t pw = floorDiv((int32_t)std::floor((x + x1 - 1) * scale), WarpCellSize) - px0 + 2;
+	const int32_t ph = floorDiv((int32_t)std::floor((y + y1 - 1) * scale), WarpCellSize) - py0 + 2;
+	const int32_t pd = floorDiv((int32_t)std::floor((z + z1 - 1) * scale), WarpCellSize) - pz0 + 2;
+	const int32_t pointCount = pw * ph * pd;
+
+	std::unique_ptr<float[]> points(new float[pointCount * 3]);
+	std::shared_ptr<const WarpTile> tile;
+
+	int pointIndex = 0;
+	for (int32_t px = px0; px < px0 + pw; ++px)
+	{
+		for (int32_t py = py0; py < py0 + ph; ++py)
+		{
+			for (int32_t pz = pz0; pz < pz0 + pd; ++pz)
+			{
+				const int32_t tx = floorDiv(px, WarpTileSize);
+				const int32_t ty = floorDiv(py, WarpTileSize);
+				const int32_t tz = floorDiv(pz, WarpTileSize);
+
+				if (!tile || tile->tx != tx || tile->ty != ty || tile->tz != tz)
+				{
+					tile = getWarpTile(tx, ty, tz);
+				}
+
+				const int32_t lx = px - (tx * WarpTileSize);
+				const int32_t ly = py - (ty * WarpTileSize);
+				const int32_t lz = pz - (tz * WarpTileSize);
+				const int32_t tileIndex = (lx * WarpTileSize * WarpTileSize) + (ly * WarpTileSize) + lz;
+
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					points[(axis * pointCount) + pointIndex] = tile->displacement[(axis * WarpTilePointCount) + tileIndex];
+				}
+				++pointIndex;
+			}
+		}
+	}
+
+	const int count = x1 * y1 * z1;
+	outVectorSet->SetSize(count);
+
+	const float invCellSize = 1.0f / WarpCellSize;
+
+	int index = 0;
+	for (int ix = 0; ix < x1; ++ix)
+	{
+		const float fx = ((x + ix) * scale * invCellSize) - px0;
+		const int32_t cx = std::min((int32_t)fx, pw - 2);
+		const float tx = fx - cx;
+
+		for (int iy = 0; iy < y1; ++iy)
+		{
+			const float fy = ((y + iy) * scale * invCellSize) - py0;
+			const int32_t cy = std::min((int32_t)fy, ph - 2);
+			const float ty = fy - cy;
+
+			for (int iz = 0; iz < z1; ++iz)
+			{
+				const float fz = ((z + iz) * scale * invCellSize) - pz0;
+				const int32_t cz = std::min((int32_t)fz, pd - 2);
+				const float tz = fz - cz;
+
+				const int32_t p000 = (cx * ph * pd) + (cy * pd) + cz;
+				const int32_t p100 = p000 + (ph * pd);
+				const int32_t p010 = p000 + pd;
+				const int32_t p110 = p100 + pd;
+
+				float d[3];
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					const float* v = points.get() + (axis * pointCount);
+
+					const float x00 = v[p000] + (v[p100] - v[p000]) * tx;
+					const float x10 = v[p010] + (v[p110] - v[p010]) * tx;
+					const float x01 = v[p000 + 1] + (v[p100 + 1] - v[p000 + 1]) * tx;
+					const float x11 = v[p010 + 1] + (v[p110 + 1] - v[p010 + 1]) * tx;
+
+					const float lerpY0 = x00 + (x10 - x00) * ty;
+					const float lerpY1 = x01 + (x11 - x01) * ty;
+
+					d[axis] = lerpY0 + (lerpY1 - lerpY0) * tz;
+				}
+
+				outVectorSet->xSet[index] = ((x + ix) * scale) + d[0];
+				outVectorSet->ySet[index] = ((y + iy) * scale) + d[1];
+				outVectorSet->zSet[index] = ((z + iz) * scale) + d[2];
+				++index;
+			}
+		}
+	}
+}
+
+static float* getLayerSet(const NoiseLayers& layerSet, int layer, int32_t x, int32_t y, int32_t z, int32_t x1, int32_t y1, int32_t z1, float scale)
+{
+	FastNoiseSIMD* noise = layerSet[layer].get();
+	const int sampleScale = layerSampleScales[layer];
+
+	// FillSampledNoiseSet has no scale modifier, coarse LODs are sparse enough already.
+	// Sampled layers are not warped.
+	if (sampleScale > 0 && scale == 1.0f)
+	{
+		return noise->GetSampledNoiseSet(x, y, z, x1, y1, z1, sampleScale);
+	}
+
+	if (warpAmplitude > 0.0f)
+	{
+		FastNoiseVectorSet warped;
+		buildWarpedLattice(&warped, x, y, z, x1, y1, z1, scale);
+
+		float* noiseSet = FastNoiseSIMD::GetEmptySet(x1 * y1 * z1);
+		noise->FillNoiseSet(noiseSet, &warped);
+		return noiseSet;
+	}
+
+	return noise->GetNoiseSet(x, y, z, x1, y1, z1, scale);
+}
+
+// Same as FastNoiseSIMD's fractal bounding, the reciprocal of the summed octave amplitudes.
+static float fractalBounding(int octaveCount)
+{
+	float amplitude = 1.0f;
+	float total = 0.0f;
+	for (int i = 0; i < octaveCount; ++i)
+	{
+		total += amplitude;
+		amplitude *= DetailGain;
+	}
+
+	return 1.0f / total;
+}
+
+static bool hasSampledDetailBands()
+{
+	for (const OctaveBand& band : detailBands)
+	{
+		if (layerSampleScales[band.layer] > 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// The detail layer, summed from its octave bands when any of them is sampled on a coarse lattice.
+static float* getDetailSet(const NoiseLayers& layerSet, int32_t x, int32_t y, int32_t z, int32_t x1, int32_t y1, int32_t z1, float scale)
 {
-	fastNoise.reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
-	fastNoise->SetFrequency(0.00776f);
-	fastNoise->SetFractalOctaves(5);
-	//fastNoise->SetAxisScales(1.0f, 2.0f, 1.0f);
+	if (scale != 1.0f || warpAmplitude > 0.0f || !hasSampledDetailBands())
+	{
+		return getLayerSet(layerSet, DetailLayer, x, y, z, x1, y1, z1, scale);
+	}
+
+	const int count = x1 * y1 * z1;
+	float* detail = FastNoiseSIMD::GetEmptySet(count);
+	std::fill(detail, detail + count, 0.0f);
+
+	// A band is normalized over its own octaves, weigh it back to its share of the full fractal.
+	const float detailBounding = fractalBounding(DetailOctaveCount);
+	for (const OctaveBand& band : detailBands)
+	{
+		const float weight = detailBounding * std::pow(DetailGain, (float)band.firstOctave) / fractalBounding(band.octaveCount);
+
+		float* bandSet = getLayerSet(layerSet, band.layer, x, y, z, x1, y1, z1, scale);
+		for (int i = 0; i < count; ++i)
+		{
+			detail[i] += bandSet[i] * weight;
+		}
+
+		FastNoiseSIMD::FreeNoiseSet(bandSet);
+	}
 
-	fastNoise2.reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
-	fastNoise2->SetFrequency(0.0036f);
-	fastNoise2->SetFractalOctaves(4);
+	return detail;
+}
+
+// Creates the layers at the current FastNoiseSIMD level.
+static void createLayers(NoiseLayers& layerSet, int seed)
+{
+	layerSet[0].reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
+	layerSet[0]->SetFrequency(0.00776f);
+	layerSet[0]->SetFractalOctaves(5);
+	//layerSet[0]->SetAxisScales(1.0f, 2.0f, 1.0f);
 
-	fastNoise3.reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
-	fastNoise3->SetFrequency(0.0025f);
-	fastNoise3->SetFractalOctaves(10);
-	//fastNoise3->SetAxisScales(1.0f, 7.0f, 1.0f);
+	layerSet[1].reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
+	layerSet[1]->SetFrequency(0.0036f);
+	layerSet[1]->SetNoiseType(FastNoiseSIMD::Cellular);
+	layerSet[1]->SetFractalOctaves(4);
+
+	layerSet[2].reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
+	layerSet[2]->SetFrequency(DetailFrequency);
+	layerSet[2]->SetFractalOctaves(DetailOctaveCount);
+	//layerSet[2]->SetAxisScales(1.0f, 7.0f, 1.0f);
 	
-	fastNoise4.reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
-	fastNoise4->SetFrequency(0.0046f);
-	fastNoise4->SetFractalOctaves(2);
-	//fastNoise4->SetAxisScales(1.0f, 0.01f, 1.0f);
+	layerSet[3].reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
+	layerSet[3]->SetFrequency(0.0046f);
+	layerSet[3]->SetFractalOctaves(2);
+	//layerSet[3]->SetAxisScales(1.0f, 0.01f, 1.0f);
+
+	layerSet[4].reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
+	layerSet[4]->SetFrequency(0.0006f);
+	layerSet[4]->SetFractalOctaves(8);
+	//layerSet[4]->SetAxisScales(1.0f, 0.01f, 1.0f);
 
-	fastNoise5.reset(FastNoiseSIMD::NewFastNoiseSIMD(seed));
-	fastNoise5->SetFrequency(0.0006f);
-	fastNoise5->SetFractalOctaves(8);
-	//fastNoise4->SetAxisScales(1.0f, 0.01f, 1.0f);
+	// Octave i of a fractal uses seed + i and twice the previous frequency.
+	for (const OctaveBand& band : detailBands)
+	{
+		layerSet[band.layer].reset(FastNoiseSIMD::NewFastNoiseSIMD(seed + band.firstOctave));
+		layerSet[band.layer]->SetFrequency(DetailFrequency * (float)(1 << band.firstOctave));
+		layerSet[band.layer]->SetFractalOctaves(band.octaveCount);
+	}
+}
 
-	//A.SetSeed(seed);
-	//A.SetFrequency(0.0032);
-	//A.SetLacunarity(10.0);
-	//A.SetOctaveCount(4);
+static void sampleLayers(
+	const NoiseLayers& layerSet,
+	float* values,
+	int32_t x,
+	int32_t y,
+	int32_t z,
+	int32_t x1,
+	int32_t y1,
+	int32_t z1,
+	float scale);
+
+void Terrain::init(int seed)
+{
+	createLayers(layers, seed);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		warpNoise[axis].reset(FastNoiseSIMD::NewFastNoiseSIMD(seed + 1 + axis));
+		warpNoise[axis]->SetFrequency(0.002f);
+		warpNoise[axis]->SetFractalOctaves(3);
+	}
+
+	A.SetSeed(seed);
+	A.SetFrequency(0.0032);
+	A.SetOctaveCount(4);
 
 	B.SetSeed(seed);
 	B.SetFrequency(0.0176);
 	B.SetOctaveCount(6);
+
+	C.SetSourceModule(0, B);
+	C.SetSeed(seed + 4);
+	C.SetFrequency(0.05);
+	C.SetPower(4.0);
+
+	surfaceRecipe.SetSourceModule(0, B);
+	surfaceRecipe.SetSourceModule(1, C);
+	surfaceRecipe.SetControlModule(A);
+	surfaceRecipe.SetBounds(0.0, 1000.0);
+	surfaceRecipe.SetEdgeFalloff(0.125);
+}
+
+void Terrain::setLayerSampleScale(int layer, int sampleScale)
+{
+	assert(layer >= 0 && layer < LayerCount);
+	assert(sampleScale >= 0 && sampleScale <= 2);
+	layerSampleScales[layer] = sampleScale;
+}
+
+int Terrain::getLayerSampleScale(int layer)
+{
+	assert(layer >= 0 && layer < LayerCount);
+	return layerSampleScales[layer];
+}
+
+void Terrain::setHeightLayerEnabled(bool enabled)
+{
+	heightLayerEnabled = enabled;
+}
+
+void Terrain::setLibnoiseRecipeEnabled(bool enabled)
+{
+	libnoiseRecipeEnabled = enabled;
+}
+
+void Terrain::setWarp(float amplitude, float frequency)
+{
+	warpAmplitude = amplitude;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		warpNoise[axis]->SetFrequency(frequency);
+	}
+
+	std::lock_guard<std::mutex> lock(warpTileCacheMutex);
+	for (std::shared_ptr<const WarpTile>& tile : warpTileCache)
+	{
+		tile.reset();
+	}
+}
+
+bool Terrain::sampleSurfaceBounds(
+	int32_t x,
+	int32_t z,
+	int32_t x1,
+	int32_t z1,
+	float scale,
+	float* outMinY,
+	float* outMaxY)
+{
+	if (!heightLayerEnabled)
+	{
+		return false;
+	}
+
+	float* heights = getLayerSet(layers, 0, x, 0, z, x1, 1, z1, scale);
+
+	const int count = x1 * z1;
+
+	float minHeight = heights[0];
+	float maxHeight = heights[0];
+	for (int i = 1; i < count; ++i)
+	{
+		minHeight = std::min(minHeight, heights[i]);
+		maxHeight = std::max(maxHeight, heights[i]);
+	}
+
+	FastNoiseSIMD::FreeNoiseSet(heights);
+
+	// Noise output is in [-1, 1], pad the detail range in case a layer overshoots slightly.
+	*outMinY = (minHeight * HeightAmplitude) - (HeightDetailAmplitude * HeightBoundsMargin);
+	*outMaxY = (maxHeight * HeightAmplitude) + (HeightDetailAmplitude * HeightBoundsMargin);
+	return true;
+}
+
+void Terrain::measureSampleError(
+	int layer,
+	int32_t x,
+	int32_t y,
+	int32_t z,
+	int32_t x1,
+	int32_t y1,
+	int32_t z1,
+	float* outMaxError,
+	float* outMeanError)
+{
+	assert(layer >= 0 && layer < LayerCount);
+
+	FastNoiseSIMD* noise = layers[layer].get();
+
+	float* reference = noise->GetNoiseSet(x, y, z, x1, y1, z1);
+	float* sampled = layer == DetailLayer 
+		? getDetailSet(layers, x, y, z, x1, y1, z1, 1.0f) 
+		: getLayerSet(layers, layer, x, y, z, x1, y1, z1, 1.0f);
+
+	const int count = x1 * y1 * z1;
+
+	float maxError = 0.0f;
+	double totalError = 0.0;
+	for (int i = 0; i < count; ++i)
+	{
+		const float error = std::abs(sampled[i] - reference[i]);
+		maxError = std::max(maxError, error);
+		totalError += error;
+	}
+
+	*outMaxError = maxError;
+	*outMeanError = count > 0 ? (float)(totalError / count) : 0.0f;
+
+	FastNoiseSIMD::FreeNoiseSet(reference);
+	FastNoiseSIMD::FreeNoiseSet(sampled);
 }
 
 //static double getValueRange(
@@ -75,10 +540,57 @@ double Terrain::surface(double x, double y, double z)
 
 	//return caveFactor*caveNoise + groundFactor*groundNoise;
 
-	return B.GetValue(x, y, z);
+	return surfaceRecipe.GetValue(x, y, z);
 }
 
-void Terrain::sample(
+void Terrain::surface(const double* x, const double* y, const double* z, double* values, size_t count)
+{
+	noise_batch::getValues(surfaceRecipe, x, y, z, values, count);
+}
+
+// Evaluates the libnoise recipe for a whole set in one batch, laid out like a noise set.
+static void sampleLibnoiseRecipe(
+	float* values,
+	int32_t x,
+	int32_t y,
+	int32_t z,
+	int32_t x1,
+	int32_t y1,
+	int32_t z1,
+	float scale)
+{
+	const size_t count = (size_t)x1 * y1 * z1;
+
+	std::unique_ptr<double[]> xSet(new double[count]);
+	std::unique_ptr<double[]> ySet(new double[count]);
+	std::unique_ptr<double[]> zSet(new double[count]);
+	std::unique_ptr<double[]> surfaceValues(new double[count]);
+
+	size_t index = 0;
+	for (int32_t ix = 0; ix < x1; ++ix)
+	{
+		for (int32_t iy = 0; iy < y1; ++iy)
+		{
+			for (int32_t iz = 0; iz < z1; ++iz)
+			{
+				xSet[index] = (double)(x + ix) * scale;
+				ySet[index] = (double)(y + iy) * scale;
+				zSet[index] = (double)(z + iz) * scale;
+				++index;
+			}
+		}
+	}
+
+	Terrain::surface(xSet.get(), ySet.get(), zSet.get(), surfaceValues.get(), count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		values[i] = (float)surfaceValues[i];
+	}
+}
+
+static void sampleLayers(
+	const NoiseLayers& layerSet,
 	float* values, 
 	int32_t x, 
 	int32_t y, 
@@ -88,14 +600,42 @@ void Terrain::sample(
 	int32_t z1, 
 	float scale)
 {
-	//float* noise1 = fastNoise->GetSimplexFractalSet(x, 0, z, x1, 1, z1, scale);
-	//float* noise2 = fastNoise2->GetCellularSet(x, y, z, x1, y1, z1, scale);
-	float* noise3 = fastNoise3->GetSimplexFractalSet(x, y, z, x1, y1, z1, scale);
-	//float* noise4 = fastNoise4->GetSimplexFractalSet(x, y, z, x1, y1, z1, scale);
-	//float* noise5 = fastNoise5->GetSimplexFractalSet(x, y, z, x1, y1, z1, scale);
+	if (libnoiseRecipeEnabled)
+	{
+		sampleLibnoiseRecipe(values, x, y, z, x1, y1, z1, scale);
+		return;
+	}
+
+	//float* noise1 = getLayerSet(layerSet, 0, x, 0, z, x1, 1, z1, scale);
+	//float* noise2 = getLayerSet(layerSet, 1, x, y, z, x1, y1, z1, scale);
+	float* noise3 = getDetailSet(layerSet, x, y, z, x1, y1, z1, scale);
+	//float* noise4 = getLayerSet(layerSet, 3, x, y, z, x1, y1, z1, scale);
+	//float* noise5 = getLayerSet(layerSet, 4, x, y, z, x1, y1, z1, scale);
 
 	const int count = x1 * y1 * z1;
 
+	if (heightLayerEnabled)
+	{
+		float* heights = getLayerSet(layerSet, 0, x, 0, z, x1, 1, z1, scale);
+
+		// Sets are laid out with z as the fastest moving axis.
+		for (int i = 0; i < count; ++i)
+		{
+			const int lx = i / (y1 * z1);
+			const int ly = (i / z1) % y1;
+			const int lz = i % z1;
+
+			const float gy = (float)(y + ly) * scale;
+			const float height = heights[lx * z1 + lz] * HeightAmplitude;
+
+			values[i] = (height - gy + noise3[i] * HeightDetailAmplitude) / HeightAmplitude;
+		}
+
+		FastNoiseSIMD::FreeNoiseSet(heights);
+		FastNoiseSIMD::FreeNoiseSet(noise3);
+		return;
+	}
+
 	/*const int count = x1 * y1 * z1;
 	for (int i = 0; i < count; ++i)
 	{
@@ -114,9 +654,104 @@ void Terrain::sample(
 
 	memcpy(values, noise3, sizeof(float) * count);
 
-	//fastNoise->FreeNoiseSet(noise1);
-	//fastNoise2->FreeNoiseSet(noise2);
-	fastNoise3->FreeNoiseSet(noise3);
-	//fastNoise4->FreeNoiseSet(noise4);
-	//fastNoise5->FreeNoiseSet(noise5);
+	//FastNoiseSIMD::FreeNoiseSet(noise1);
+	//FastNoiseSIMD::FreeNoiseSet(noise2);
+	FastNoiseSIMD::FreeNoiseSet(noise3);
+	//FastNoiseSIMD::FreeNoiseSet(noise4);
+	//FastNoiseSIMD::FreeNoiseSet(noise5);
+}
+
+void Terrain::sample(
+	float* values, 
+	int32_t x, 
+	int32_t y, 
+	int32_t z, 
+	int32_t x1, 
+	int32_t y1, 
+	int32_t z1, 
+	float scale)
+{
+	sampleLayers(layers, values, x, y, z, x1, y1, z1, scale);
+}
+
+bool Terrain::verifySIMDConformance(int seed)
+{
+#ifndef FN_DETERMINISTIC
+	// Levels are free to differ in the last bits, there is nothing to hold them to.
+	(void)seed;
+	return true;
+#else
+	// One block per LOD, away from the origin so the lattice hashes see negative coordinates too.
+	constexpr int32_t BlockSize = 33;
+	constexpr int BlockCount = 3;
+	const int32_t blocks[BlockCount][3] = {
+		{ 0, 0, 0 },
+		{ -1057, -96, 2211 },
+		{ 40000, 17, -31999 },
+	};
+	const float blockScales[BlockCount] = { 1.0f, 4.0f, 16.0f };
+
+	// Only levels that are compiled in, a level that isn't would silently fall through to the next one.
+	const int levels[] = {
+#ifdef FN_COMPILE_NEON
+		FN_NEON,
+#endif
+#ifdef FN_COMPILE_AVX512
+		FN_AVX512,
+#endif
+#ifdef FN_COMPILE_AVX2
+		FN_AVX2,
+#endif
+#ifdef FN_COMPILE_SSE41
+		FN_SSE41,
+#endif
+#ifdef FN_COMPILE_SSE2
+		FN_SSE2,
+#endif
+#ifdef FN_COMPILE_NO_SIMD_FALLBACK
+		FN_NO_SIMD_FALLBACK,
+#endif
+	};
+
+	const int count = BlockSize * BlockSize * BlockSize;
+	const int fastestLevel = FastNoiseSIMD::GetSIMDLevel();
+
+	std::unique_ptr<float[]> reference(new float[count * BlockCount]);
+	std::unique_ptr<float[]> values(new float[count]);
+
+	bool hasReference = false;
+	bool matches = true;
+
+	// Sets are padded to the level's vector width, so every level gets its own layers and sets.
+	for (int level : levels)
+	{
+		if (level > fastestLevel)
+		{
+			continue;
+		}
+
+		FastNoiseSIMD::SetSIMDLevel(level);
+
+		NoiseLayers levelLayers;
+		createLayers(levelLayers, seed);
+
+		for (int i = 0; i < BlockCount; ++i)
+		{
+			float* blockReference = reference.get() + (i * count);
+			float* blockValues = hasReference ? values.get() : blockReference;
+
+			sampleLayers(levelLayers, blockValues, blocks[i][0], blocks[i][1], blocks[i][2], BlockSize, BlockSize, BlockSize, blockScales[i]);
+
+			if (hasReference && memcmp(blockValues, blockReference, sizeof(float) * count) != 0)
+			{
+				matches = false;
+			}
+		}
+
+		hasReference = true;
+	}
+
+	FastNoiseSIMD::SetSIMDLevel(fastestLevel);
+	return matches;
+#endif
 }
\ No newline at end of file
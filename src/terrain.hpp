@@ -1,12 +1,47 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 class Terrain
 {
 public:
+	// Layers 5 to 7 are octave bands of the detail layer 2.
+	static constexpr int LayerCount = 8;
+
 	static void init(int seed);
+	// The libnoise recipe at a world space position.
 	static double surface(double x, double y, double z);
+	// Batched surface(), evaluates the libnoise graph on SoA coordinates.
+	static void surface(const double* x, const double* y, const double* z, double* values, size_t count);
+
+	// Evaluates a noise layer on a coarse lattice 2^sampleScale units apart and trilinearly 
+	// upsamples the result. 0 evaluates every sample. Only used for full resolution (scale 1) sets.
+	static void setLayerSampleScale(int layer, int sampleScale);
+	static int getLayerSampleScale(int layer);
+
+	// Switches to the 2.5D recipe where layer 0 is a height field and the 3D noise only adds detail around it.
+	static void setHeightLayerEnabled(bool enabled);
+
+	// Samples the libnoise recipe through the batched surface() instead of the FastNoiseSIMD layers.
+	static void setLibnoiseRecipeEnabled(bool enabled);
+
+	// Displaces sample positions by a low frequency noise field, amplitude is in world units and 0 disables it.
+	// Call before sampling starts, cached warp tiles are dropped but in-flight samples are not synchronized.
+	static void setWarp(float amplitude, float frequency);
+
+	// Returns the world space height band that contains the surface above the given 2D footprint, 
+	// in the same axis order as sample(). Returns false if the active recipe has no height layer.
+	static bool sampleSurfaceBounds(int32_t x, int32_t z, int32_t w, int32_t d, float scale, float* outMinY, float* outMaxY);
+
+	// Compares the upsampled output of a layer against full evaluation over the given block. The detail 
+	// layer 2 is measured as the sum of its bands.
+	static void measureSampleError(int layer, int32_t x, int32_t y, int32_t z, int32_t w, int32_t h, int32_t d, float* outMaxError, float* outMeanError);
+
+	// Compares sample() bit for bit across every SIMD level this CPU supports, they only match with FN_DETERMINISTIC.
+	// Always passes when it is turned off.
+	// Switches the global FastNoiseSIMD level while it runs, call it before anything else samples terrain.
+	static bool verifySIMDConformance(int seed);
 
 	static void sample(float* values, int32_t x, int32_t y, int32_t z, int32_t w, int32_t h, int32_t d, float scale);
-};
\ No newline at end of file
+};
@@ -0,0 +1,317 @@
+#include "topology.hpp"
+#include "error.hpp"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <fstream>
+#include <string>
+#endif
+
+#include <algorithm>
+#include <memory>
+
+namespace topology
+{
+
+#if defined(_WIN32)
+
+static void queryCores(std::vector<Core>& outCores, std::vector<uint32_t>& outRawClasses)
+{
+	DWORD length = 0;
+	GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+
+	std::unique_ptr<uint8_t[]> buffer(new uint8_t[length]);
+	if (GetLogicalProcessorInformationEx(RelationProcessorCore, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.get(), &length) == FALSE)
+	{
+		fatalError("%s", "GetLogicalProcessorInformationEx failed");
+	}
+
+	for (DWORD offset = 0; offset < length;)
+	{
+		const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer.get() + offset);
+		offset += info->Size;
+
+		Core core;
+		core.coreClass = 0;
+
+		for (WORD groupIndex = 0; groupIndex < info->Processor.GroupCount; ++groupIndex)
+		{
+			const GROUP_AFFINITY& affinity = info->Processor.GroupMask[groupIndex];
+			for (uint32_t bit = 0; bit < 64; ++bit)
+			{
+				if (affinity.Mask & ((KAFFINITY)1 << bit))
+				{
+					core.processors.push_back((uint32_t)affinity.Group * 64 + bit);
+				}
+			}
+		}
+
+		outCores.push_back(core);
+
+		// Higher is faster, zero everywhere on machines without hybrid cores.
+		outRawClasses.push_back(info->Processor.EfficiencyClass);
+	}
+}
+
+bool pinCurrentThread(uint32_t processor)
+{
+	GROUP_AFFINITY affinity{};
+	affinity.Group = (WORD)(processor / 64);
+	affinity.Mask = (KAFFINITY)1 << (processor % 64);
+
+	return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != FALSE;
+}
+
+void unpinCurrentThread()
+{
+	DWORD_PTR processMask;
+	DWORD_PTR systemMask;
+	if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) != FALSE)
+	{
+		SetThreadAffinityMask(GetCurrentThread(), processMask);
+	}
+}
+
+void setCurrentThreadBackground()
+{
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+#elif defined(__linux__)
+
+static bool readUint(const std::string& path, uint32_t& outValue)
+{
+	std::ifstream file(path);
+	return (bool)(file >> outValue);
+}
+
+// Parses sysfs cpu lists such as "0-3,8,10-11".
+static std::vector<uint32_t> readCpuList(const std::string& path)
+{
+	std::vector<uint32_t> cpus;
+
+	std::ifstream file(path);
+	std::string list;
+	if (!std::getline(file, list))
+	{
+		return cpus;
+	}
+
+	size_t begin = 0;
+	while (begin < list.size())
+	{
+		size_t end = list.find(',', begin);
+		if (end == std::string::npos)
+		{
+			end = list.size();
+		}
+
+		const std::string range = list.substr(begin, end - begin);
+		const size_t dash = range.find('-');
+
+		const uint32_t first = (uint32_t)std::stoul(range.substr(0, dash));
+		const uint32_t last = dash == std::string::npos ? first : (uint32_t)std::stoul(range.substr(dash + 1));
+
+		for (uint32_t cpu = first; cpu <= last; ++cpu)
+		{
+			cpus.push_back(cpu);
+		}
+
+		begin = end + 1;
+	}
+
+	return cpus;
+}
+
+static void queryCores(std::vector<Core>& outCores, std::vector<uint32_t>& outRawClasses)
+{
+	const std::string cpuRoot = "/sys/devices/system/cpu/";
+
+	// Intel hybrid parts list their P-cores and E-cores as separate PMUs.
+	const std::vector<uint32_t> performanceCpus = readCpuList("/sys/devices/cpu_core/cpus");
+
+	struct CoreKey
+	{
+		uint32_t package;
+		uint32_t coreId;
+		size_t coreIndex;
+	};
+	std::vector<CoreKey> keys;
+
+	for (uint32_t cpu : readCpuList(cpuRoot + "online"))
+	{
+		const std::string cpuPath = cpuRoot + "cpu" + std::to_string(cpu) + "/";
+
+		uint32_t package = 0;
+		uint32_t coreId = cpu;
+		readUint(cpuPath + "topology/physical_package_id", package);
+		readUint(cpuPath + "topology/core_id", coreId);
+
+		auto it = std::find_if(keys.begin(), keys.end(), [&](const CoreKey& key) {
+			return key.package == package && key.coreId == coreId;
+		});
+
+		if (it != keys.end())
+		{
+			outCores[it->coreIndex].processors.push_back(cpu);
+			continue;
+		}
+
+		// Arm big.LITTLE exposes a relative capacity, failing that the fastest clock tells the classes apart.
+		uint32_t rawClass = 0;
+		if (!performanceCpus.empty())
+		{
+			rawClass = std::find(performanceCpus.begin(), performanceCpus.end(), cpu) != performanceCpus.end() ? 1 : 0;
+		}
+		else if (!readUint(cpuPath + "cpu_capacity", rawClass))
+		{
+			readUint(cpuPath + "cpufreq/cpuinfo_max_freq", rawClass);
+		}
+
+		keys.push_back(CoreKey{ package, coreId, outCores.size() });
+
+		Core core;
+		core.coreClass = 0;
+		core.processors.push_back(cpu);
+		outCores.push_back(core);
+		outRawClasses.push_back(rawClass);
+	}
+}
+
+bool pinCurrentThread(uint32_t processor)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(processor, &set);
+
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+void unpinCurrentThread()
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	for (const Core& core : get().cores)
+	{
+		for (uint32_t processor : core.processors)
+		{
+			CPU_SET(processor, &set);
+		}
+	}
+
+	sched_setaffinity(0, sizeof(set), &set);
+}
+
+void setCurrentThreadBackground()
+{
+	sched_param param{};
+	param.sched_priority = 0;
+	sched_setscheduler(0, SCHED_BATCH, &param);
+}
+
+#endif
+
+static Topology queryTopology()
+{
+	Topology topology;
+
+	std::vector<uint32_t> rawClasses;
+	queryCores(topology.cores, rawClasses);
+
+	if (topology.cores.empty())
+	{
+		fatalError("%s", "failed to query the processor topology");
+	}
+
+	// Rank the raw values, they are capacities or clocks on some systems.
+	std::vector<uint32_t> distinctClasses = rawClasses;
+	std::sort(distinctClasses.begin(), distinctClasses.end());
+	distinctClasses.erase(std::unique(distinctClasses.begin(), distinctClasses.end()), distinctClasses.end());
+
+	// Only the fastest classes are told apart if there are more of them than we have room for.
+	const size_t skippedClassCount = distinctClasses.size() > MaxCoreClasses ? distinctClasses.size() - MaxCoreClasses : 0;
+
+	topology.processorCount = 0;
+	for (size_t i = 0; i < topology.cores.size(); ++i)
+	{
+		Core& core = topology.cores[i];
+
+		const size_t rank = std::lower_bound(distinctClasses.begin(), distinctClasses.end(), rawClasses[i]) - distinctClasses.begin();
+		core.coreClass = (uint32_t)(rank > skippedClassCount ? rank - skippedClassCount : 0);
+
+		std::sort(core.processors.begin(), core.processors.end());
+		topology.processorCount += (uint32_t)core.processors.size();
+	}
+
+	topology.coreClassCount = (uint32_t)(distinctClasses.size() - skippedClassCount);
+
+	std::sort(topology.cores.begin(), topology.cores.end(), [](const Core& a, const Core& b) {
+		return a.processors[0] < b.processors[0];
+	});
+
+	return topology;
+}
+
+const Topology& get()
+{
+	static const Topology topology = queryTopology();
+	return topology;
+}
+
+std::vector<uint32_t> planWorkers(const WorkerPlacement& placement, uint32_t* outMainProcessor)
+{
+	const Topology& topology = get();
+
+	// Fastest cores first, the lowest numbered one of those is left to the main thread.
+	std::vector<const Core*> cores;
+	for (const Core& core : topology.cores)
+	{
+		cores.push_back(&core);
+	}
+
+	std::stable_sort(cores.begin(), cores.end(), [](const Core* a, const Core* b) {
+		return a->coreClass > b->coreClass;
+	});
+
+	*outMainProcessor = NoProcessor;
+	if (placement.reserveMainCore)
+	{
+		if (placement.pinWorkers)
+		{
+			*outMainProcessor = cores.front()->processors[0];
+		}
+
+		cores.erase(cores.begin());
+	}
+
+	uint32_t workersPerClass[MaxCoreClasses] = {};
+	std::vector<uint32_t> workers;
+
+	for (const Core* core : cores)
+	{
+		const size_t threadCount = placement.smtPolicy == SmtPolicy::AllThreads ? core->processors.size() : 1;
+
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			if (workersPerClass[core->coreClass] >= placement.maxWorkersPerCoreClass[core->coreClass])
+			{
+				break;
+			}
+
+			workersPerClass[core->coreClass]++;
+			workers.push_back(placement.pinWorkers ? core->processors[i] : NoProcessor);
+		}
+	}
+
+	if (workers.empty())
+	{
+		workers.push_back(NoProcessor);
+	}
+
+	return workers;
+}
+
+}
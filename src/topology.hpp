@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Which logical processors share a physical core, and how fast each core is relative to the others.
+namespace topology
+{
+
+constexpr uint32_t MaxCoreClasses = 4;
+constexpr uint32_t NoProcessor = UINT32_MAX;
+
+struct Core
+{
+	// Ranked from 0 for the slowest cores, everything is class 0 on machines without hybrid cores.
+	uint32_t coreClass;
+	// Logical processor numbers of the core's hardware threads, the primary thread first.
+	std::vector<uint32_t> processors;
+};
+
+struct Topology
+{
+	// Ordered by logical processor number of their primary thread.
+	std::vector<Core> cores;
+	uint32_t coreClassCount;
+	uint32_t processorCount;
+};
+
+// Queried from the OS on first use.
+const Topology& get();
+
+enum class SmtPolicy
+{
+	// One worker per physical core, on its primary thread.
+	PhysicalCores,
+	// One worker per hardware thread.
+	AllThreads,
+};
+
+struct WorkerPlacement
+{
+	// Pin every worker to its own logical processor, otherwise the OS moves them around.
+	bool pinWorkers = false;
+	SmtPolicy smtPolicy = SmtPolicy::PhysicalCores;
+	// Leaves the fastest core to the thread that starts the workers, the render thread.
+	// When pinning, that thread is pinned to the core's primary thread.
+	bool reserveMainCore = true;
+	// Below normal priority on Windows, SCHED_BATCH on Linux.
+	bool backgroundPriority = true;
+	// Caps the workers placed on each core class, indexed by Core::coreClass.
+	uint32_t maxWorkersPerCoreClass[MaxCoreClasses] = { UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX };
+};
+
+// Returns one entry per worker, the logical processor to pin it to or NoProcessor if it isn't pinned.
+// Faster cores are used first and there is always at least one worker. outMainProcessor receives the
+// processor the calling thread should be pinned to, or NoProcessor.
+std::vector<uint32_t> planWorkers(const WorkerPlacement& placement, uint32_t* outMainProcessor);
+
+bool pinCurrentThread(uint32_t processor);
+void unpinCurrentThread();
+void setCurrentThreadBackground();
+
+}
@@ -2,7 +2,10 @@
 
 #include "descriptor_set_writer.hpp"
 #include "terrain.hpp"
+#include "chunk_generation.hpp"
+#include "chunk_lod.hpp"
 #include "error.hpp"
+#include "jobs.hpp"
 
 #include <DirectXMath.h>
 #include <DirectXPackedVector.h>
@@ -11,6 +14,7 @@
 #include <tracy/Tracy.hpp>
 
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
@@ -19,24 +23,47 @@
 #include <Windows.h>
 
 #include <vector>
+#include <algorithm>
 #include <future>
 #include <iostream>
 #include <fstream>
+#include <chrono>
 
 using namespace DirectX;
 
+// Nodes along each side of every LOD level's streaming region.
 constexpr uint32_t DrawDistance = 18;
-
-constexpr uint32_t ChunkSideSize = 32;
-constexpr uint32_t ChunkSideHalfSize = ChunkSideSize / 2;
-constexpr uint32_t ChunkMaxLOD = 5;
-
-static void initChunkBuffers(
-	uint32_t lodLevel, 
-	const glm::i32vec3& origin,
-	glm::vec3** outPositions,
-	glm::vec3** outNormals,
-	size_t* outVertexCount);
+constexpr size_t ChunkGridLevelSize = DrawDistance * DrawDistance * DrawDistance;
+// Marks a grid cell whose node isn't in the LOD selection.
+constexpr uint32_t NoLodNode = UINT32_MAX;
+// What the LOD selection expects a node to cost before any of its level are loaded, a flat surface 
+// through it.
+constexpr float DefaultLodVertexCount = (float)(ChunkSideSize * ChunkSideSize * 6);
+// Leaves with nothing above them loaded get a fallback this many levels coarser while progressive 
+// loading, one chunk standing in for up to 64 of them.
+constexpr uint32_t ChunkFallbackLevelCount = 2;
+
+// The camera moves up to a chunk between LOD selections, chunks that close to the fog are streamed in
+// ahead of time.
+constexpr float ChunkStreamingMargin = (float)ChunkSideSize;
+// Chunks the LOD selection no longer wants are only unloaded this much further out than the streamed
+// sphere, going back and forth over its edge doesn't load them over and over.
+constexpr float ChunkUnloadMargin = (float)(2 * ChunkSideSize);
+// A region follows the camera once it is more than this many nodes off its centre along an axis, rather
+// than with every node the camera crosses.
+constexpr int32_t ChunkRegionHysteresis = 1;
+// Chunk requests straight behind the camera are ordered as if they were this many times further away.
+constexpr float ChunkBehindPriorityScale = 3.0f;
+// Seconds between reordering the chunk requests while the streaming region stays put.
+constexpr float ChunkPriorityRefreshInterval = 0.1f;
+// Generated chunks waiting for upload are capped at this many frames worth of staging buffer.
+constexpr size_t ChunkUploadBacklogFrames = 4;
+// Work items in flight to the main thread, every one has its slot reserved before its job starts.
+constexpr uint32_t MainThreadWorkQueueCapacity = 64 * 1024;
+// Per job thread channel to the main thread, a frame's worth of chunks from one thread is well below it.
+constexpr size_t ThreadWorkQueueCapacity = 1024;
+
+static float getChunkPriority(const glm::i32vec3& position, uint32_t lodLevel, const ChunkPriorityView& view);
 
 bool g_cullingEnabled = true;
 bool g_gpuCullingEnabled = false;
@@ -89,116 +116,825 @@ private:
 	VkDeviceSize m_offset;
 };
 
-static size_t getCoreCount()
+static const char* const ChunkStageActivePlotNames[ChunkStage_Count] = {
+	"Sample Stage Active Jobs",
+	"Classify Stage Active Jobs",
+	"Triangulate Stage Active Jobs",
+	"Pack Stage Active Jobs",
+	"Allocate Stage Active Jobs",
+};
+
+static const char* const ChunkStageQueuedPlotNames[ChunkStage_Count] = {
+	"Sample Stage Queued Chunks",
+	"Classify Stage Queued Chunks",
+	"Triangulate Stage Queued Chunks",
+	"Pack Stage Queued Chunks",
+	"Allocate Stage Queued Chunks",
+};
+
+// Staging bytes a loaded chunk needs, positions and normals back to back.
+static size_t getChunkUploadSize(size_t vertexCount)
+{
+	return vertexCount * sizeof(glm::vec3) * 2;
+}
+
+// Chunk coordinates wrap around their level's grid, so a chunk's cell doesn't depend on where the 
+// region is.
+static size_t getChunkCellIndex(const glm::i32vec3& position, uint32_t lodLevel)
+{
+	const int32_t size = (int32_t)DrawDistance;
+	const int32_t x = ((position.x % size) + size) % size;
+	const int32_t y = ((position.y % size) + size) % size;
+	const int32_t z = ((position.z % size) + size) % size;
+	return lodLevel * ChunkGridLevelSize + (size_t)((z * size + y) * size + x);
+}
+
+static bool isChunkInFlight(ChunkCell cell)
+{
+	const ChunkCellState state = getChunkCellState(cell);
+	return state == ChunkCellState_Claimed || state == ChunkCellState_Generating || state == ChunkCellState_Uploading;
+}
+
+// Culled chunks are known to be empty, they are as good as loaded.
+static bool isChunkReady(ChunkCell cell)
+{
+	const ChunkCellState state = getChunkCellState(cell);
+	return state == ChunkCellState_Resident || state == ChunkCellState_Culled;
+}
+
+// Appends every chunk in [regionMin, regionMax) that isn't in [prevRegionMin, prevRegionMax).
+static void collectEnteringChunks(
+	const glm::i32vec3& prevRegionMin, 
+	const glm::i32vec3& prevRegionMax, 
+	const glm::i32vec3& regionMin, 
+	const glm::i32vec3& regionMax, 
+	std::vector<glm::i32vec3>& outChunks)
+{
+	outChunks.clear();
+
+	// Empty on an axis the region jumped further than its size along.
+	const glm::i32vec3 overlapMin = glm::max(prevRegionMin, regionMin);
+	const glm::i32vec3 overlapMax = glm::min(prevRegionMax, regionMax);
+
+	for (int32_t z = regionMin.z; z < regionMax.z; ++z)
+	{
+		for (int32_t y = regionMin.y; y < regionMax.y; ++y)
+		{
+			const bool isRowInOverlap = 
+				z >= overlapMin.z && z < overlapMax.z && 
+				y >= overlapMin.y && y < overlapMax.y && 
+				overlapMin.x < overlapMax.x;
+
+			if (!isRowInOverlap)
+			{
+				for (int32_t x = regionMin.x; x < regionMax.x; ++x)
+				{
+					outChunks.push_back(glm::i32vec3(x, y, z));
+				}
+				continue;
+			}
+
+			// Only what is either side of the row's overlap entered.
+			for (int32_t x = regionMin.x; x < overlapMin.x; ++x)
+			{
+				outChunks.push_back(glm::i32vec3(x, y, z));
+			}
+
+			for (int32_t x = overlapMax.x; x < regionMax.x; ++x)
+			{
+				outChunks.push_back(glm::i32vec3(x, y, z));
+			}
+		}
+	}
+}
+
+// 21 bits per axis, chunk coordinates are far inside a million either way.
+static uint64_t packChunkPosition(const glm::i32vec3& position)
+{
+	return 
+		((uint64_t)(uint32_t)position.x & 0x1fffff) | 
+		(((uint64_t)(uint32_t)position.y & 0x1fffff) << 21) | 
+		(((uint64_t)(uint32_t)position.z & 0x1fffff) << 42);
+}
+
+static bool tryIncrementBelow(std::atomic<uint32_t>& value, uint32_t limit)
+{
+	uint32_t current = value.load(std::memory_order_relaxed);
+	while (current < limit)
+	{
+		if (value.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void World::_pumpChunkPipeline()
+{
+	// Later stages first, finishing chunks frees the queue slots the earlier stages stall on.
+	for (uint32_t i = ChunkStage_Count; i-- > 0;)
+	{
+		ChunkPipelineStage& stage = m_chunkStages[i];
+
+		while (_hasChunkStageWork(stage.stage) && tryIncrementBelow(m_activeChunkJobs, m_chunkJobBudget.load(std::memory_order_relaxed)))
+		{
+			if (!tryIncrementBelow(stage.activeJobs, stage.maxActiveJobs))
+			{
+				m_activeChunkJobs.fetch_sub(1, std::memory_order_relaxed);
+				break;
+			}
+
+			jobs::run(chunkStageJobEP, &stage, &m_chunkJobCounter);
+		}
+	}
+}
+
+bool World::_hasChunkStageWork(ChunkStage stage)
+{
+	const ChunkPipelineStage& current = m_chunkStages[stage];
+
+	if (stage + 1 < ChunkStage_Count)
+	{
+		const ChunkPipelineStage& next = m_chunkStages[stage + 1];
+		if (next.reservedCount.load(std::memory_order_relaxed) >= ChunkPipelineStage::QueueCapacity)
+		{
+			return false;
+		}
+	}
+
+	if (stage == ChunkStage_Sample)
+	{
+		return m_isRunning && !_isUploadBacklogFull() && m_chunkScheduler.queuedCount() > 0 && 
+			m_reservedMainThreadWork.load(std::memory_order_relaxed) < MainThreadWorkQueueCapacity;
+	}
+
+	return current.input.unsafe_size() > 0;
+}
+
+void World::chunkStageJobEP(void* data)
+{
+	ChunkPipelineStage* stage = static_cast<ChunkPipelineStage*>(data);
+	stage->world->_runChunkStage(stage->stage);
+}
+
+void World::_runChunkStage(ChunkStage stage)
+{
+	// Give the core back as soon as the throttle cuts the budget, jobs that were queued before the cut
+	// don't even start.
+	while (m_activeChunkJobs.load(std::memory_order_relaxed) <= m_chunkJobBudget.load(std::memory_order_relaxed))
+	{
+		ChunkTask* task = _takeChunkTask(stage);
+		if (!task)
+		{
+			break;
+		}
+
+		_processChunkTask(stage, task);
+
+		// Taking the task may have unblocked the previous stage.
+		_pumpChunkPipeline();
+	}
+
+	m_chunkStages[stage].activeJobs.fetch_sub(1, std::memory_order_release);
+	m_activeChunkJobs.fetch_sub(1, std::memory_order_release);
+
+	// Work can arrive between the last look and giving up the job slot.
+	_pumpChunkPipeline();
+}
+
+World::ChunkTask* World::_claimChunkTask()
+{
+	ChunkScheduler::Request request;
+	while (m_chunkScheduler.pop(request))
+	{
+		// A request can outlive its cell being recycled or cancelled, until the next selection drops it.
+		// The cell has moved on then and the chunk is either not wanted any more or requested again.
+		const ChunkCell generating = makeChunkCell(getChunkCellGeneration(request.cell), ChunkCellState_Generating);
+		ChunkCell expected = request.cell;
+		if (!m_chunkGrid.cells[getChunkCellIndex(request.position, request.lodLevel)].compare_exchange_strong(expected, generating, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			if (getChunkCellGeneration(expected) != getChunkCellGeneration(request.cell))
+			{
+				m_staleChunkRequests.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				m_chunkClaimConflicts.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			continue;
+		}
+
+		ChunkTask* task = new ChunkTask();
+		task->cell = generating;
+		task->result.position = request.position;
+		task->result.lodLevel = (uint8_t)request.lodLevel;
+		return task;
+	}
+
+	return nullptr;
+}
+
+World::ChunkTask* World::_claimChunkTask(const glm::i32vec3& position, uint32_t lodLevel)
+{
+	// Only a chunk still waiting in the scheduler, its request there fails to claim it afterwards.
+	std::atomic<ChunkCell>& cell = m_chunkGrid.cells[getChunkCellIndex(position, lodLevel)];
+	ChunkCell expected = cell.load(std::memory_order_relaxed);
+	if (getChunkCellState(expected) != ChunkCellState_Claimed)
+	{
+		return nullptr;
+	}
+
+	const ChunkCell generating = makeChunkCell(getChunkCellGeneration(expected), ChunkCellState_Generating);
+	if (!cell.compare_exchange_strong(expected, generating, std::memory_order_acq_rel, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+
+	ChunkTask* task = new ChunkTask();
+	task->cell = generating;
+	task->result.position = position;
+	task->result.lodLevel = (uint8_t)lodLevel;
+	return task;
+}
+
+World::ChunkTask* World::_takeChunkTask(ChunkStage stage)
+{
+	ChunkPipelineStage& current = m_chunkStages[stage];
+
+	// Reserve room downstream first, a task that has been taken never waits half way through.
+	ChunkPipelineStage* next = stage + 1 < ChunkStage_Count ? &m_chunkStages[stage + 1] : nullptr;
+	if (next && !tryIncrementBelow(next->reservedCount, ChunkPipelineStage::QueueCapacity))
+	{
+		return nullptr;
+	}
+
+	ChunkTask* task = nullptr;
+
+	if (stage == ChunkStage_Sample)
+	{
+		// Its main thread work slot too, a finished chunk never waits for room there.
+		if (m_isRunning && !_isUploadBacklogFull() && tryIncrementBelow(m_reservedMainThreadWork, MainThreadWorkQueueCapacity))
+		{
+			task = _claimChunkTask();
+			if (!task)
+			{
+				m_reservedMainThreadWork.fetch_sub(1, std::memory_order_release);
+			}
+		}
+	}
+	else if (current.input.dequeue(task))
+	{
+		current.reservedCount.fetch_sub(1, std::memory_order_release);
+	}
+
+	if (!task && next)
+	{
+		next->reservedCount.fetch_sub(1, std::memory_order_release);
+	}
+
+	return task;
+}
+
+void World::_processChunkTask(ChunkStage stage, ChunkTask* task)
+{
+	// The region can move on at any point, stale chunks are abandoned before they cost the next stage.
+	if (stage != ChunkStage_Sample && m_chunkGrid.cells[getChunkCellIndex(task->result.position, task->result.lodLevel)].load(std::memory_order_acquire) != task->cell)
+	{
+		m_staleChunkDrops.fetch_add(1, std::memory_order_relaxed);
+		_dropChunkTask(stage, task);
+		return;
+	}
+
+	switch (stage)
+	{
+		case ChunkStage_Sample:
+		{
+			task->terrainSamples = sampleChunk(task->result.lodLevel, task->result.position);
+			break;
+		}
+		case ChunkStage_Classify:
+		{
+			if (!hasSurfaceCrossing(task->terrainSamples.get()))
+			{
+				// Nothing to triangulate, it is loaded as an empty chunk straight away.
+				m_chunkStages[ChunkStage_Triangulate].reservedCount.fetch_sub(1, std::memory_order_release);
+				_finishChunkTask(task);
+				return;
+			}
+			break;
+		}
+		case ChunkStage_Triangulate:
+		{
+			triangulateChunk(task->result.lodLevel, task->result.position, task->terrainSamples.get(), task->vertices, task->normals);
+			task->terrainSamples.reset();
+			break;
+		}
+		case ChunkStage_Pack:
+		{
+			packChunkBuffers(
+				task->vertices, 
+				task->normals, 
+				&task->result.chunkPositionBuffer, 
+				&task->result.chunkNormalBuffer, 
+				&task->result.chunkVertexCount);
+
+			// The triangulation reserves for the worst case, don't hold on to it while waiting.
+			std::vector<glm::vec3>().swap(task->vertices);
+			std::vector<glm::vec3>().swap(task->normals);
+			break;
+		}
+		case ChunkStage_Allocate:
+		{
+			_initVisualChunk(task->result.visualChunk, task->result.chunkVertexCount);
+			_finishChunkTask(task);
+			return;
+		}
+	}
+
+	_forwardChunkTask(stage, task);
+}
+
+void World::_forwardChunkTask(ChunkStage stage, ChunkTask* task)
+{
+	// The slot was reserved when the task was taken.
+	while (!m_chunkStages[stage + 1].input.enqueue(task));
+}
+
+void World::_finishChunkTask(ChunkTask* task)
+{
+	// Handed to the main thread either way, it owns the chunk's buffers. One that lost its cell is 
+	// dropped there.
+	ChunkCell expected = task->cell;
+	task->result.cell = makeChunkCell(getChunkCellGeneration(task->cell), ChunkCellState_Uploading);
+	if (!m_chunkGrid.cells[getChunkCellIndex(task->result.position, task->result.lodLevel)].compare_exchange_strong(expected, task->result.cell, std::memory_order_acq_rel, std::memory_order_relaxed))
+	{
+		m_staleChunkDrops.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	m_pendingUploadBytes.fetch_add(getChunkUploadSize(task->result.chunkVertexCount), std::memory_order_relaxed);
+
+	WorkItem outWork;
+	outWork.type = WorkItemType::ChunkLoaded;
+	outWork.chunkLoaded = task->result;
+	_pushMainThreadWork(outWork);
+
+	delete task;
+}
+
+void World::_dropChunkTask(ChunkStage stage, ChunkTask* task)
+{
+	if (stage + 1 < ChunkStage_Count)
+	{
+		m_chunkStages[stage + 1].reservedCount.fetch_sub(1, std::memory_order_release);
+	}
+
+	m_reservedMainThreadWork.fetch_sub(1, std::memory_order_release);
+
+	delete[] task->result.chunkPositionBuffer;
+	delete[] task->result.chunkNormalBuffer;
+	delete task;
+}
+
+ChunkRequest World::requestChunk(const glm::i32vec3& position, uint32_t lodLevel)
+{
+	assert(lodLevel <= ChunkMaxLOD);
+
+	std::shared_ptr<ChunkRequestState> state(new ChunkRequestState());
+	state->result.position = position;
+	state->result.lodLevel = lodLevel;
+
+	m_queuedChunkRequests.push_back(new ChunkRequestJob{ this, state });
+	_startChunkRequests();
+
+	return ChunkRequest(state);
+}
+
+void World::_startChunkRequests()
+{
+	// Under the same budget and backpressure as the chunk stages, a burst of requests can't take over the
+	// cores the throttle has given back to the frame.
+	size_t startedCount = 0;
+	while (startedCount < m_queuedChunkRequests.size() && m_isRunning && !_isUploadBacklogFull())
+	{
+		if (!tryIncrementBelow(m_activeChunkJobs, m_chunkJobBudget.load(std::memory_order_relaxed)))
+		{
+			break;
+		}
+
+		if (!tryIncrementBelow(m_reservedMainThreadWork, MainThreadWorkQueueCapacity))
+		{
+			m_activeChunkJobs.fetch_sub(1, std::memory_order_relaxed);
+			break;
+		}
+
+		jobs::run(chunkRequestJobEP, m_queuedChunkRequests[startedCount++], &m_chunkJobCounter);
+	}
+
+	m_queuedChunkRequests.erase(m_queuedChunkRequests.begin(), m_queuedChunkRequests.begin() + startedCount);
+}
+
+void World::_cancelChunkRequest(ChunkRequestJob* job)
+{
+	// Nothing will ever complete the request, the coroutines awaiting it are destroyed where they are
+	// suspended rather than leaked.
+	std::unique_ptr<ChunkRequestJob> owned(job);
+
+	std::vector<std::coroutine_handle<>> waiters;
+	waiters.swap(job->state->waiters);
+	for (std::coroutine_handle<> waiter : waiters)
+	{
+		waiter.destroy();
+	}
+}
+
+void World::_pushMainThreadWork(const WorkItem& work)
+{
+	// No CAS on the thread's own channel, workers don't contend with each other there.
+	const size_t threadIndex = jobs::currentThreadIndex();
+	if (threadIndex < m_threadWorkQueues.size() && m_threadWorkQueues[threadIndex]->enqueue(work))
+	{
+		return;
+	}
+
+	// The slot was reserved before the job that did the work started.
+	if (!m_mainThreadWorkQueue.enqueue(work))
+	{
+		fatalError("%s", "main thread work queue is fuller than its reservations");
+	}
+}
+
+size_t World::_popMainThreadWork(WorkItem* work, size_t maxCount)
+{
+	size_t count = 0;
+	for (const std::unique_ptr<spsc_bounded_queue<WorkItem>>& queue : m_threadWorkQueues)
+	{
+		while (count < maxCount && queue->dequeue(work[count]))
+		{
+			++count;
+		}
+	}
+
+	return count + m_mainThreadWorkQueue.dequeue_n(work + count, maxCount - count);
+}
+
+size_t World::_countMainThreadWork() const
+{
+	size_t count = m_mainThreadWorkQueue.unsafe_size();
+	for (const std::unique_ptr<spsc_bounded_queue<WorkItem>>& queue : m_threadWorkQueues)
+	{
+		count += queue->unsafe_size();
+	}
+
+	return count;
+}
+
+static void buildChunkRequest(ChunkRequestResult& result)
+{
+	std::unique_ptr<float[]> terrainSamples = sampleChunk(result.lodLevel, result.position);
+
+	std::shared_ptr<ChunkMesh> mesh(new ChunkMesh());
+	if (hasSurfaceCrossing(terrainSamples.get()))
+	{
+		triangulateChunk(result.lodLevel, result.position, terrainSamples.get(), mesh->vertices, mesh->normals);
+
+		// The triangulation reserves for the worst case and the mesh may be held on to for a while.
+		mesh->vertices.shrink_to_fit();
+		mesh->normals.shrink_to_fit();
+	}
+
+	result.density = std::move(terrainSamples);
+	result.mesh = std::move(mesh);
+}
+
+void World::chunkRequestJobEP(void* data)
+{
+	ZoneScoped;
+
+	ChunkRequestJob* job = static_cast<ChunkRequestJob*>(data);
+	World* world = job->world;
+	ChunkRequestResult& result = job->state->result;
+
+	// Handed back untouched once the world is going away, it cancels the request.
+	if (world->m_isRunning)
+	{
+		buildChunkRequest(result);
+	}
+
+	WorkItem outWork;
+	outWork.type = WorkItemType::ChunkRequestDone;
+	outWork.chunkRequestDone.job = job;
+	world->_pushMainThreadWork(outWork);
+
+	world->m_activeChunkJobs.fetch_sub(1, std::memory_order_release);
+	world->_pumpChunkPipeline();
+}
+
+void World::_loadChunkInParallel(const glm::i32vec3& cameraPosChunkSpace)
+{
+	ZoneScoped;
+
+	// The leaf the camera is in, not whatever the scheduler has on top, that is often a coarse fallback.
+	// Once it is on its way the pipeline finishes it like any other chunk.
+	const uint32_t leafIndex = _findLodLeaf(cameraPosChunkSpace);
+	if (leafIndex == NoLodNode)
+	{
+		return;
+	}
+
+	const ChunkLodNode& leaf = m_lodSelector.getNodes()[leafIndex];
+
+	// Enters the pipeline at the pack stage, which has to have room for it before anything is claimed.
+	ChunkPipelineStage& pack = m_chunkStages[ChunkStage_Pack];
+	if (!tryIncrementBelow(pack.reservedCount, ChunkPipelineStage::QueueCapacity))
+	{
+		return;
+	}
+
+	if (!tryIncrementBelow(m_reservedMainThreadWork, MainThreadWorkQueueCapacity))
+	{
+		pack.reservedCount.fetch_sub(1, std::memory_order_release);
+		return;
+	}
+
+	ChunkTask* task = _claimChunkTask(leaf.position, leaf.lodLevel);
+	if (!task)
+	{
+		pack.reservedCount.fetch_sub(1, std::memory_order_release);
+		m_reservedMainThreadWork.fetch_sub(1, std::memory_order_release);
+		return;
+	}
+
+	const uint32_t lodLevel = task->result.lodLevel;
+	const uint32_t cellPlaneCount = ChunkSideSize;
+	const uint32_t samplePlaneCount = cellPlaneCount + 1;
+	const uint32_t slabCount = std::min((uint32_t)jobs::workerCount() + 1, cellPlaneCount);
+
+	// Every worker is needed for the slabs, the stage jobs return after their current task while the
+	// throttle is paused.
+	m_chunkJobBudget.store(m_generationThrottle.pause(), std::memory_order_relaxed);
+
+	task->terrainSamples.reset(new float[samplePlaneCount * samplePlaneCount * samplePlaneCount]);
+
+	jobs::parallelFor(slabCount, 1, [task, lodLevel, samplePlaneCount, slabCount](size_t i) {
+		const uint32_t firstPlane = (uint32_t)i * samplePlaneCount / slabCount;
+		const uint32_t endPlane = ((uint32_t)i + 1) * samplePlaneCount / slabCount;
+		sampleChunkSlab(lodLevel, task->result.position, firstPlane, endPlane - firstPlane, task->terrainSamples.get());
+	});
+
+	if (!hasSurfaceCrossing(task->terrainSamples.get()))
+	{
+		pack.reservedCount.fetch_sub(1, std::memory_order_release);
+		_finishChunkTask(task);
+	}
+	else
+	{
+		struct Slab
+		{
+			std::vector<glm::vec3> vertices;
+			std::vector<glm::vec3> normals;
+		};
+		std::unique_ptr<Slab[]> slabs(new Slab[slabCount]);
+
+		jobs::parallelFor(slabCount, 1, [task, lodLevel, cellPlaneCount, slabCount, &slabs](size_t i) {
+			const uint32_t firstPlane = (uint32_t)i * cellPlaneCount / slabCount;
+			const uint32_t endPlane = ((uint32_t)i + 1) * cellPlaneCount / slabCount;
+			triangulateChunkSlab(lodLevel, task->result.position, task->terrainSamples.get(), firstPlane, endPlane - firstPlane, slabs[i].vertices, slabs[i].normals);
+		});
+
+		task->terrainSamples.reset();
+
+		// In slab order, the same triangles in the same order as a single triangulateChunk.
+		for (uint32_t i = 0; i < slabCount; ++i)
+		{
+			task->vertices.insert(task->vertices.end(), slabs[i].vertices.begin(), slabs[i].vertices.end());
+			task->normals.insert(task->normals.end(), slabs[i].normals.begin(), slabs[i].normals.end());
+		}
+
+		_forwardChunkTask(ChunkStage_Triangulate, task);
+	}
+
+	m_chunkJobBudget.store(m_generationThrottle.resume(), std::memory_order_relaxed);
+}
+
+bool World::_isUploadBacklogFull() const
 {
-	DWORD returnLength = 0;
-	GetLogicalProcessorInformation(nullptr, &returnLength);
+	// Generation stops taking new chunks rather than piling up meshes, and the VMA memory behind them, 
+	// faster than they can be uploaded.
+	return m_pendingUploadBytes.load(std::memory_order_relaxed) >= ChunkUploadBacklogFrames * m_chunkStagingBufferSize;
+}
+
+void World::_uploadChunks()
+{
+	ZoneScoped;
 
-	const DWORD count = returnLength / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
-	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> logicalProcessorInformation(count);
-	if (GetLogicalProcessorInformation(logicalProcessorInformation.data(), &returnLength) == FALSE)
+	m_stagingCopies.clear();
+
+	const ChunkPriorityView view = _getChunkPriorityView();
+
+	for (size_t i = 0; i < m_pendingUploads.size();)
 	{
-		fatalError("%s", "GetLogicalProcessorInformation failed");
+		PendingChunkUpload& upload = m_pendingUploads[i];
+
+		const glm::i32vec3& position = upload.chunk.position;
+		if (m_chunkGrid.cells[getChunkCellIndex(position, upload.chunk.lodLevel)].load(std::memory_order_relaxed) != upload.chunk.cell)
+		{
+			// The cell was recycled after the worker last checked it, or while the chunk waited here.
+			_dropChunkUpload(upload.chunk);
+			upload = m_pendingUploads.back();
+			m_pendingUploads.pop_back();
+			continue;
+		}
+
+		// Ordered like the scheduler orders requests, the camera has moved since they were generated.
+		upload.priority = _getChunkPriority(position, upload.chunk.lodLevel, view);
+		++i;
 	}
 
-	size_t coreCount = 0;
-	for (SYSTEM_LOGICAL_PROCESSOR_INFORMATION& processorInfo : logicalProcessorInformation)
+	// std heaps keep the largest element on top.
+	auto comparePendingChunkUploads = [](const PendingChunkUpload& a, const PendingChunkUpload& b) {
+		return a.priority > b.priority;
+	};
+
+	std::make_heap(m_pendingUploads.begin(), m_pendingUploads.end(), comparePendingChunkUploads);
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	size_t stagingBufferOffset = 0;
+	bool hasUploaded = false;
+
+	while (!m_pendingUploads.empty())
 	{
-		switch (processorInfo.Relationship)
+		// Only taken out of the queue once it is known to fit, whatever doesn't waits for the next frame.
+		const size_t uploadSize = getChunkUploadSize(m_pendingUploads.front().chunk.chunkVertexCount);
+
+		if (stagingBufferOffset + uploadSize > m_chunkStagingBufferSizes[m_frameIndex])
 		{
-			case RelationProcessorCore:
-				coreCount++;
+			// A chunk that would never fit grows this frame's buffer instead of waiting for it forever.
+			if (uploadSize <= m_chunkStagingBufferSize)
+			{
 				break;
+			}
+
+			_growStagingBuffer(stagingBufferOffset, stagingBufferOffset + uploadSize);
+		}
+
+		// The first chunk always goes, so uploads make progress however slow the copies are.
+		const std::chrono::duration<float> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+		if (hasUploaded && elapsed.count() >= m_uploadTimeBudget)
+		{
+			break;
 		}
+
+		std::pop_heap(m_pendingUploads.begin(), m_pendingUploads.end(), comparePendingChunkUploads);
+		_commitChunkUpload(m_pendingUploads.back().chunk, stagingBufferOffset);
+		m_pendingUploads.pop_back();
+
+		stagingBufferOffset += uploadSize;
+		hasUploaded = true;
+	}
+
+	TracyPlot("Staging Buffer Usage", (int64_t)stagingBufferOffset);
+	TracyPlot("Pending Upload Count", (int64_t)m_pendingUploads.size());
+	TracyPlot("Pending Upload Bytes", (int64_t)m_pendingUploadBytes.load(std::memory_order_relaxed));
+}
+
+void World::_commitChunkUpload(WorkItemData_ChunkLoaded& chunk, size_t stagingBufferOffset)
+{
+	const size_t vertexCount = chunk.chunkVertexCount;
+	const VisualChunk& vchunk = chunk.visualChunk;
+
+	assert(vchunk.vertexCount == vertexCount);
+
+	if (vchunk.vertexCount > 0) {
+		const size_t positionDataSize = vertexCount * sizeof(glm::vec3);
+		const size_t normalDataSize = vertexCount * sizeof(glm::vec3);
+
+		const size_t vertexDataOffset = 0;
+		const size_t normalDataOffset = positionDataSize;
+
+		uint8_t* mappedMemory = ((uint8_t*)m_chunkStagingBufferData[m_frameIndex]) + stagingBufferOffset;
+
+		memcpy(mappedMemory + vertexDataOffset, chunk.chunkPositionBuffer, positionDataSize);
+		memcpy(mappedMemory + normalDataOffset, chunk.chunkNormalBuffer, normalDataSize);
+
+		StagingCopy copy{};
+
+		copy.size = positionDataSize;
+		copy.dstBuffer = vchunk.vertexBuffer;
+		copy.srcOffset = stagingBufferOffset + vertexDataOffset;
+		m_stagingCopies.push_back(copy);
+
+		copy.size = normalDataSize;
+		copy.dstBuffer = vchunk.normalBuffer;
+		copy.srcOffset = stagingBufferOffset + normalDataOffset;
+		m_stagingCopies.push_back(copy);
 	}
 
-	return coreCount;
+	delete[] chunk.chunkPositionBuffer;
+	delete[] chunk.chunkNormalBuffer;
+
+	m_pendingUploadBytes.fetch_sub(getChunkUploadSize(vertexCount), std::memory_order_relaxed);
+
+	ChunkHandle chunkHandle = m_chunks.add();
+	const uint32_t chunkIndex = m_chunks.lookup(chunkHandle);
+
+	m_chunks.visuals[chunkIndex] = chunk.visualChunk;
+	m_chunks.positions[chunkIndex] = chunk.position;
+	m_chunks.lodLevels[chunkIndex] = chunk.lodLevel;
+
+	m_lodVertexCounts[chunk.lodLevel] += vertexCount;
+	m_lodChunkCounts[chunk.lodLevel] += 1;
+	m_areDrawnChunksStale = true;
+
+	// Nothing but the main thread touches an uploading cell. The fence keeps findChunk from pairing 
+	// the new handle with a cell it read before the recycle, the store publishes it to findChunk.
+	const size_t cellIndex = getChunkCellIndex(chunk.position, chunk.lodLevel);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_chunkGrid.handles[cellIndex].store(chunkHandle, std::memory_order_relaxed);
+	m_chunkGrid.positions[cellIndex].store(packChunkPosition(chunk.position), std::memory_order_relaxed);
+	m_chunkGrid.cells[cellIndex].store(makeChunkCell(getChunkCellGeneration(chunk.cell), ChunkCellState_Resident), std::memory_order_release);
+}
+
+void World::_dropChunkUpload(WorkItemData_ChunkLoaded& chunk)
+{
+	delete[] chunk.chunkPositionBuffer;
+	delete[] chunk.chunkNormalBuffer;
+	_freeChunkBuffers(chunk.visualChunk);
+
+	m_pendingUploadBytes.fetch_sub(getChunkUploadSize(chunk.chunkVertexCount), std::memory_order_relaxed);
 }
 
-void World::_workerThreadEP(size_t workerIndex, size_t workerCount)
+bool World::findChunk(const glm::i32vec3& position, uint32_t lodLevel, ChunkHandle& outHandle) const
 {
-	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+	assert(lodLevel <= ChunkMaxLOD);
+
+	const size_t cellIndex = getChunkCellIndex(position, lodLevel);
+	const std::atomic<ChunkCell>& cell = m_chunkGrid.cells[cellIndex];
+
+	// The cell works as a sequence lock, it is recycled to a new generation before the handle changes.
+	const ChunkCell observed = cell.load(std::memory_order_acquire);
+	if (getChunkCellState(observed) != ChunkCellState_Resident)
+	{
+		return false;
+	}
 
-	//const std::string threadName = "Worker " + std::to_string(workerIndex);
-	//rmt_SetCurrentThreadName(threadName.c_str());
+	const ChunkHandle handle = m_chunkGrid.handles[cellIndex].load(std::memory_order_relaxed);
+	const uint64_t packedPosition = m_chunkGrid.positions[cellIndex].load(std::memory_order_relaxed);
 
-	struct Work
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (cell.load(std::memory_order_relaxed) != observed)
 	{
-		glm::i32vec3 position;
-	};
+		return false;
+	}
 
-	while (m_isRunning)
+	// The cell is shared by every coordinate DrawDistance apart, it may hold another one's chunk.
+	if (packedPosition != packChunkPosition(position))
 	{
-		bool hasWork = false;
-		Work work;
+		return false;
+	}
 
-		size_t closestGridIndex = (size_t)-1;
-		float closestDistance = 1000000.0f;
+	outHandle = handle;
+	return true;
+}
 
-		m_gridMutex.lock_shared();
+bool World::_hasChunksAround(const glm::i32vec3& position) const
+{
+	for (int32_t z = position.z - 1; z <= position.z + 1; ++z)
+	{
+		for (int32_t y = position.y - 1; y <= position.y + 1; ++y)
 		{
-			ZoneScopedN("Aquire Work");
-
-			// Check if any chunks need updating.
-			const size_t gridSize = DrawDistance * DrawDistance * DrawDistance;
-			for (size_t gridIndex = workerIndex; gridIndex < gridSize; gridIndex += workerCount)
+			for (int32_t x = position.x - 1; x <= position.x + 1; ++x)
 			{
-				if (m_chunkGrid.occupation[gridIndex] == 0)
+				// Whatever level the selection covers the spot with.
+				const uint32_t leafIndex = _findLodLeaf(glm::i32vec3(x, y, z));
+				if (leafIndex == NoLodNode)
 				{
-					const uint32_t grid_x = (uint32_t)gridIndex % DrawDistance;
-					const uint32_t grid_y = ((uint32_t)gridIndex / DrawDistance) % DrawDistance;
-					const uint32_t grid_z = ((uint32_t)gridIndex / DrawDistance) / DrawDistance;
-
-					const float gridCenter = (float)(DrawDistance / 2) + 0.5f;
+					continue;
+				}
 
-					const float dx = grid_x - gridCenter;
-					const float dy = grid_y - gridCenter;
-					const float dz = grid_z - gridCenter;
+				const ChunkLodNode& leaf = m_lodSelector.getNodes()[leafIndex];
+				if (isChunkReady(m_chunkGrid.cells[getChunkCellIndex(leaf.position, leaf.lodLevel)].load(std::memory_order_relaxed)))
+				{
+					return true;
+				}
 
-					const float distance = dx * dx + dy * dy + dz * dz;
-					if (distance < closestDistance)
+				// A fallback drawn in its place will do, see _selectChunkLods.
+				glm::i32vec3 ancestorPosition = leaf.position;
+				for (uint32_t ancestorLevel = leaf.lodLevel + 1; ancestorLevel <= ChunkMaxLOD; ++ancestorLevel)
+				{
+					ancestorPosition = ancestorPosition >> 1;
+					if (getChunkCellState(m_chunkGrid.cells[getChunkCellIndex(ancestorPosition, ancestorLevel)].load(std::memory_order_relaxed)) == ChunkCellState_Resident)
 					{
-						closestDistance = distance;
-						closestGridIndex = gridIndex;
-
-						work.position.x = m_chunkGrid.regionMin.x + grid_x;
-						work.position.y = m_chunkGrid.regionMin.y + grid_y;
-						work.position.z = m_chunkGrid.regionMin.z + grid_z;
+						return true;
 					}
-
-					hasWork = true;
 				}
 			}
 		}
-		m_gridMutex.unlock_shared();
-
-		if (hasWork)
-		{
-			m_chunkGrid.occupation[closestGridIndex] = 1;
-
-			size_t vertexCount;
-			glm::vec3* positionBuffer;
-			glm::vec3* normalBuffer;
-			initChunkBuffers(0, work.position, &positionBuffer, &normalBuffer, &vertexCount);
-
-			VisualChunk visualChunk;
-			_initVisualChunk(visualChunk, vertexCount);
-
-			WorkItem outWork;
-			outWork.type = WorkItemType::ChunkLoaded;
-			outWork.chunkLoaded.chunkVertexCount = vertexCount;
-			outWork.chunkLoaded.chunkPositionBuffer = positionBuffer;
-			outWork.chunkLoaded.chunkNormalBuffer = normalBuffer;
-			outWork.chunkLoaded.visualChunk = visualChunk;
-			outWork.chunkLoaded.position = work.position;
-			while (!m_mainThreadWorkQueue.enqueue(outWork));
-		}
-		else
-		{
-			using namespace std::chrono_literals;
-			std::this_thread::sleep_for(16ms); // take a chill pill
-		}
 	}
+
+	return false;
 }
 
 void World::_createSamplers()
@@ -439,69 +1175,169 @@ void World::_createUniformBuffer()
 	}
 }
 
-void World::_createStagingBuffer()
+void World::_createStagingBuffer(size_t i, VkDeviceSize size)
 {
-	for (size_t i = 0; i < 5; ++i) {
-		VkBufferCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		createInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		createInfo.size = m_chunkStagingBufferSize;
+	VkBufferCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	createInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	createInfo.size = size;
 
-		if (vkCreateBuffer(graphics::device, &createInfo, nullptr, &m_chunkStagingBuffer[i]) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create staging buffer!");
-		}
+	if (vkCreateBuffer(graphics::device, &createInfo, nullptr, &m_chunkStagingBuffer[i]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create staging buffer!");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements(graphics::device, m_chunkStagingBuffer[i], &memoryRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memoryRequirements.size;
+	allocInfo.memoryTypeIndex = graphics::findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-		VkMemoryRequirements memoryRequirements;
-		vkGetBufferMemoryRequirements(graphics::device, m_chunkStagingBuffer[i], &memoryRequirements);
+	if (vkAllocateMemory(graphics::device, &allocInfo, nullptr, &m_chunkStagingBufferMemory[i]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate staging buffer memory!");
+	}
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memoryRequirements.size;
-		allocInfo.memoryTypeIndex = graphics::findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	if (vkBindBufferMemory(graphics::device, m_chunkStagingBuffer[i], m_chunkStagingBufferMemory[i], 0) != VK_SUCCESS) {
+		throw std::runtime_error("failed to bind staging buffer memory!");
+	}
 
-		if (vkAllocateMemory(graphics::device, &allocInfo, nullptr, &m_chunkStagingBufferMemory[i]) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate staging buffer memory!");
-		}
+	if (vkMapMemory(graphics::device, m_chunkStagingBufferMemory[i], 0ull, VK_WHOLE_SIZE, 0, &m_chunkStagingBufferData[i]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to map chunk staging buffer!");
+	}
 
-		if (vkBindBufferMemory(graphics::device, m_chunkStagingBuffer[i], m_chunkStagingBufferMemory[i], 0) != VK_SUCCESS) {
-			throw std::runtime_error("failed to bind staging buffer memory!");
-		}
+	m_chunkStagingBufferSizes[i] = size;
+}
 
-		if (vkMapMemory(graphics::device, m_chunkStagingBufferMemory[i], 0ull, VK_WHOLE_SIZE, 0, &m_chunkStagingBufferData[i]) != VK_SUCCESS) {
-			throw std::runtime_error("failed to map chunk staging buffer!");
-		}
+void World::_destroyStagingBuffer(size_t i)
+{
+	vkUnmapMemory(graphics::device, m_chunkStagingBufferMemory[i]);
+	vkFreeMemory(graphics::device, m_chunkStagingBufferMemory[i], nullptr);
+	vkDestroyBuffer(graphics::device, m_chunkStagingBuffer[i], nullptr);
+}
+
+void World::_growStagingBuffer(size_t usedSize, VkDeviceSize minSize)
+{
+	// The GPU is done with this frame's buffer, it is being filled. The copies recorded so far refer to
+	// it by frame index and the staged bytes move over, so they carry on as they were.
+	const VkBuffer buffer = m_chunkStagingBuffer[m_frameIndex];
+	const VkDeviceMemory memory = m_chunkStagingBufferMemory[m_frameIndex];
+	const void* data = m_chunkStagingBufferData[m_frameIndex];
+
+	VkDeviceSize size = m_chunkStagingBufferSizes[m_frameIndex];
+	while (size < minSize)
+	{
+		size *= 2;
 	}
+
+	_createStagingBuffer(m_frameIndex, size);
+	memcpy(m_chunkStagingBufferData[m_frameIndex], data, usedSize);
+
+	vkUnmapMemory(graphics::device, memory);
+	vkFreeMemory(graphics::device, memory, nullptr);
+	vkDestroyBuffer(graphics::device, buffer, nullptr);
 }
 
 World::World()
 	: m_isRunning(true)
 	, m_freezeFrustum(false)
-	, m_mainThreadWorkQueue(64 * 1024)
+	, m_mainThreadWorkQueue(MainThreadWorkQueueCapacity)
+	, m_reservedMainThreadWork(0)
 	, m_prevCameraPosChunkSpace(INT32_MAX, INT32_MAX, INT32_MAX)
 	, m_frameIndex(0)
 	, m_temporalTargetIndex(0)
 	, m_isHistoryValid(false)
 	, m_chunkStagingBufferSize(4 * 1024 * 1024)
 	, m_chunks(*this)
+	, m_isLodSelectionStale(true)
+	, m_areDrawnChunksStale(false)
+	, m_drawnChunksUpdateIndex(0)
+	, m_retainedChunkBudget(64 * 1024 * 1024)
+	, m_isProgressiveLoading(true)
+	, m_isHorizonComplete(false)
+	, m_horizonLoadTime(0.0f)
+	, m_lodVertexCounts{}
+	, m_lodChunkCounts{}
+	, m_fogStart(32.0f)
+	, m_fogEnd(128.0f)
+	, m_prefetchLookAhead(0.75f)
+	, m_chunkPriorityRefreshTimer(0.0f)
+	, m_chunkClaimConflicts(0)
+	, m_staleChunkRequests(0)
+	, m_staleChunkDrops(0)
+	, m_pendingUploadBytes(0)
+	, m_uploadTimeBudget(0.001f)
+	, m_activeChunkJobs(0)
+	, m_generationThrottle(1.0f / 60.0f, (uint32_t)jobs::workerCount())
 {
-	Terrain::init(static_cast<int>(time(nullptr)));
+	const int seed = static_cast<int>(time(nullptr));
+
+#if !CONFIG_RETAIL
+	if (!Terrain::verifySIMDConformance(seed))
+	{
+		fatalError("%s", "terrain noise differs between SIMD levels");
+	}
+#endif
+
+	Terrain::init(seed);
+
+	for (size_t i = 0; i <= jobs::workerCount(); ++i)
+	{
+		m_threadWorkQueues.emplace_back(new spsc_bounded_queue<WorkItem>(ThreadWorkQueueCapacity));
+	}
+
+	// Sampling and triangulation dominate, packing is a copy and VMA serializes allocations anyway.
+	const uint32_t workerCount = (uint32_t)jobs::workerCount();
+	m_chunkJobBudget = workerCount;
+
+	const uint32_t maxActiveJobs[ChunkStage_Count] = {
+		workerCount,
+		workerCount,
+		workerCount,
+		std::max(workerCount / 2, 1u),
+		1,
+	};
+
+	for (uint32_t i = 0; i < ChunkStage_Count; ++i)
+	{
+		m_chunkStages[i].world = this;
+		m_chunkStages[i].stage = (ChunkStage)i;
+		m_chunkStages[i].maxActiveJobs = maxActiveJobs[i];
+	}
 }
 
 World::~World()
 {
 	m_isRunning = false;
-	for (auto&& t : m_threads)
+	jobs::wait(&m_chunkJobCounter);
+
+	// Whatever the workers finished since the last update, freed with the pending uploads below.
+	WorkItem work;
+	while (_popMainThreadWork(&work, 1) != 0)
 	{
-		if (t.joinable())
+		switch (work.type)
 		{
-			t.join();
+			case WorkItemType::ChunkLoaded:
+			{
+				m_pendingUploads.push_back(PendingChunkUpload{ 0.0f, work.chunkLoaded });
+				break;
+			}
+			case WorkItemType::ChunkRequestDone:
+			{
+				_cancelChunkRequest(work.chunkRequestDone.job);
+				break;
+			}
 		}
 	}
 
+	for (ChunkRequestJob* job : m_queuedChunkRequests)
+	{
+		_cancelChunkRequest(job);
+	}
+	m_queuedChunkRequests.clear();
+
 	for (size_t i = 0; i < 5; ++i) {
-		vkUnmapMemory(graphics::device, m_chunkStagingBufferMemory[i]);
-		vkFreeMemory(graphics::device, m_chunkStagingBufferMemory[i], nullptr);
-		vkDestroyBuffer(graphics::device, m_chunkStagingBuffer[i], nullptr);
+		_destroyStagingBuffer(i);
 	}
 
 	vkFreeMemory(graphics::device, m_uniformBufferMemory, nullptr);
@@ -515,6 +1351,23 @@ World::~World()
 		}
 	}
 
+	for (auto&& upload : m_pendingUploads) {
+		delete[] upload.chunk.chunkPositionBuffer;
+		delete[] upload.chunk.chunkNormalBuffer;
+
+		auto&& vchunk = upload.chunk.visualChunk;
+		if (vchunk.vertexBuffer != VK_NULL_HANDLE && vchunk.normalBuffer != VK_NULL_HANDLE) {
+			vmaDestroyBuffer(m_chunkAllocator, vchunk.vertexBuffer, vchunk.vertexBufferAlloc);
+			vmaDestroyBuffer(m_chunkAllocator, vchunk.normalBuffer, vchunk.normalBufferAlloc);
+		}
+	}
+
+	for (size_t i = 0; i < 5; ++i) {
+		for (auto&& dd : m_deferredDeletes[i]) {
+			vmaDestroyBuffer(m_chunkAllocator, dd.buffer, dd.allocation);
+		}
+	}
+
 	vmaDestroyAllocator(m_chunkAllocator);
 
 	vkDestroyPipeline(graphics::device, m_chunkPipeline, nullptr);
@@ -742,7 +1595,9 @@ void World::init()
 	_createChunkPipeline();
 
 	_createChunkAllocator();
-	_createStagingBuffer();
+	for (size_t i = 0; i < 5; ++i) {
+		_createStagingBuffer(i, m_chunkStagingBufferSize);
+	}
 
 	_createUniformBuffer();
 
@@ -840,237 +1695,850 @@ void World::init()
 			.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		};
 
-        if (vkCreateImage(graphics::device, &imageInfo, nullptr, &m_resolvedColor[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create image!");
-        }
+        if (vkCreateImage(graphics::device, &imageInfo, nullptr, &m_resolvedColor[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image!");
+        }
+
+        graphics::allocateAndBindDedicatedImageMemory(m_resolvedColor[i], &m_resolvedColorMemory[i]);
+
+        const VkImageViewCreateInfo viewInfo{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.image = m_resolvedColor[i],
+			.viewType = VK_IMAGE_VIEW_TYPE_2D,
+			.format = imageInfo.format,
+			.subresourceRange = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.levelCount = 1,
+				.layerCount = 1,
+			},
+		};
+
+        if (vkCreateImageView(graphics::device, &viewInfo, nullptr, &m_resolvedColorView[i])) {
+            throw std::runtime_error("failed to create image view!");
+        }
+
+		const std::string name = "Resolved_Color_" + std::to_string(i);
+		graphics::setObjectDebugName(m_resolvedColor[i], name);
+		graphics::setObjectDebugName(m_resolvedColorView[i], name);
+    }
+
+	m_debugRenderer.reset(new DebugRenderer(m_descriptorPool));
+
+	const size_t gridSize = ChunkGridLevelSize * (ChunkMaxLOD + 1);
+	m_chunkGrid.cells.reset(new std::atomic<ChunkCell>[gridSize]);
+	m_chunkGrid.handles.reset(new std::atomic<ChunkHandle>[gridSize]);
+	m_chunkGrid.positions.reset(new std::atomic<uint64_t>[gridSize]);
+	m_chunkGrid.lodNodes.reset(new uint32_t[gridSize]);
+	for (size_t i = 0; i < gridSize; ++i)
+	{
+		m_chunkGrid.cells[i].store(makeChunkCell(0, ChunkCellState_Empty), std::memory_order_relaxed);
+		m_chunkGrid.handles[i].store(ChunkHandle{}, std::memory_order_relaxed);
+		m_chunkGrid.positions[i].store(0, std::memory_order_relaxed);
+		m_chunkGrid.lodNodes[i] = NoLodNode;
+	}
+
+	const size_t columnCount = DrawDistance * DrawDistance;
+	m_chunkGrid.columnBounds.reset(new ChunkColumnBounds[columnCount]);
+	for (size_t i = 0; i < columnCount; ++i)
+	{
+		m_chunkGrid.columnBounds[i].column = glm::i32vec2(INT32_MAX, INT32_MAX);
+		m_chunkGrid.columnBounds[i].hasBounds = false;
+	}
+
+	// Empty until the first update, every cell enters the region then.
+	for (uint32_t lodLevel = 0; lodLevel <= ChunkMaxLOD; ++lodLevel)
+	{
+		m_chunkGrid.regionMin[lodLevel] = glm::i32vec3(0, 0, 0);
+		m_chunkGrid.regionMax[lodLevel] = glm::i32vec3(0, 0, 0);
+	}
+}
+
+void World::update(float dt, Input& input)
+{
+	ZoneScoped;
+
+	TracyPlot("Chunk Count", (int64_t)m_chunks.count());
+	TracyPlot("Main Thread Work Amount", (int64_t)_countMainThreadWork());
+	TracyPlot("Queued Chunk Count", (int64_t)m_chunkScheduler.queuedCount());
+	TracyPlot("Chunk Claim Conflicts", (int64_t)m_chunkClaimConflicts.exchange(0, std::memory_order_relaxed));
+	TracyPlot("Stale Chunk Requests", (int64_t)m_staleChunkRequests.exchange(0, std::memory_order_relaxed));
+	TracyPlot("Stale Chunk Drops", (int64_t)m_staleChunkDrops.exchange(0, std::memory_order_relaxed));
+	TracyPlot("Visible Missing Chunk Count", (int64_t)_countVisibleMissingChunks());
+
+	m_chunkJobBudget.store(m_generationThrottle.update(dt), std::memory_order_relaxed);
+
+	TracyPlot("Chunk Job Budget", (int64_t)m_generationThrottle.getJobBudget());
+	TracyPlot("Active Chunk Jobs", (int64_t)m_activeChunkJobs.load(std::memory_order_relaxed));
+	TracyPlot("Smoothed Frame Time", m_generationThrottle.getSmoothedFrameTime() * 1000.0f);
+	TracyPlot("Target Frame Time", m_generationThrottle.getTargetFrameTime() * 1000.0f);
+
+	for (uint32_t i = 0; i < ChunkStage_Count; ++i)
+	{
+		TracyPlot(ChunkStageActivePlotNames[i], (int64_t)m_chunkStages[i].activeJobs.load(std::memory_order_relaxed));
+
+		// The sample stage's queue is the scheduler.
+		TracyPlot(ChunkStageQueuedPlotNames[i], i == ChunkStage_Sample ? 
+			(int64_t)m_chunkScheduler.queuedCount() : 
+			(int64_t)m_chunkStages[i].reservedCount.load(std::memory_order_relaxed));
+	}
+
+	//m_btWorld->stepSimulation(dt);
+
+	GamepadState gamepad;
+	if (input.getGamepadState(gamepad))
+	{
+		static bool yButtonPrev = false;
+
+		if (gamepad.isButtonDown(GamepadButton::Y) && !yButtonPrev)
+		{
+			m_freezeFrustum = !m_freezeFrustum;
+		}
+
+		yButtonPrev = gamepad.isButtonDown(GamepadButton::Y);
+	}
+
+	{
+		ZoneScopedN("Perform Work");
+
+		// Drained in batches, the thread channels first and then the shared queue, where one CAS claims the rest.
+		WorkItem workBatch[32];
+		while (const size_t workCount = _popMainThreadWork(workBatch, std::size(workBatch)))
+		{
+			m_reservedMainThreadWork.fetch_sub((uint32_t)workCount, std::memory_order_release);
+
+			for (size_t workIndex = 0; workIndex < workCount; ++workIndex)
+			{
+				WorkItem& work = workBatch[workIndex];
+				switch (work.type)
+				{
+					case WorkItemType::ChunkLoaded:
+					{
+						// Uploaded below, in priority order and as many as the staging buffer takes this frame.
+						m_pendingUploads.push_back(PendingChunkUpload{ 0.0f, work.chunkLoaded });
+						break;
+					}
+					case WorkItemType::ChunkRequestDone:
+					{
+						std::unique_ptr<ChunkRequestJob> job(work.chunkRequestDone.job);
+
+						ChunkRequestState& state = *job->state;
+						state.isDone = true;
+
+						for (std::coroutine_handle<> waiter : state.waiters)
+						{
+							waiter.resume();
+						}
+						state.waiters.clear();
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	_startChunkRequests();
+
+	_uploadChunks();
+
+	m_camera.update(input, dt);
+
+	const glm::vec3& cameraPos = m_camera.getPosition();
+	const glm::i32vec3 cameraPosChunkSpace(glm::floor(cameraPos / (float)ChunkSideSize));
+
+	if (cameraPosChunkSpace.x != m_prevCameraPosChunkSpace.x || 
+		cameraPosChunkSpace.y != m_prevCameraPosChunkSpace.y ||
+		cameraPosChunkSpace.z != m_prevCameraPosChunkSpace.z ||
+		m_isLodSelectionStale)
+	{
+		ZoneScopedN("Update Grid");
+
+		for (uint32_t lodLevel = 0; lodLevel <= ChunkMaxLOD; ++lodLevel)
+		{
+			const glm::i32vec3 cameraNode(glm::floor(cameraPos / (float)(ChunkSideSize << lodLevel)));
+
+			// Going back and forth over a node border doesn't recycle a slab each time, the camera is
+			// let off the region's centre by up to ChunkRegionHysteresis nodes.
+			glm::i32vec3 regionCenter = m_chunkGrid.regionMin[lodLevel] + (int32_t)(DrawDistance / 2);
+			const bool isRegionEmpty = m_chunkGrid.regionMin[lodLevel] == m_chunkGrid.regionMax[lodLevel];
+			for (int32_t axis = 0; axis < 3; ++axis)
+			{
+				if (isRegionEmpty || std::abs(cameraNode[axis] - regionCenter[axis]) > ChunkRegionHysteresis)
+				{
+					regionCenter[axis] = cameraNode[axis];
+				}
+			}
+
+			const glm::i32vec3 regionMin = regionCenter - (int32_t)(DrawDistance / 2);
+			const glm::i32vec3 regionMax = regionCenter + (int32_t)(DrawDistance / 2);
+
+			if (lodLevel == 0)
+			{
+				_updateColumnBounds(regionMin, _getStreamingRadius());
+			}
+
+			// Only the slabs that entered the region are touched, however many chunks are loaded. The
+			// coarser a level, the less often its region moves at all.
+			collectEnteringChunks(m_chunkGrid.regionMin[lodLevel], m_chunkGrid.regionMax[lodLevel], regionMin, regionMax, m_enteringChunks[lodLevel]);
+
+			m_chunkGrid.regionMin[lodLevel] = regionMin;
+			m_chunkGrid.regionMax[lodLevel] = regionMax;
+		}
+
+		_recycleChunkCells();
+		_selectChunkLods(_getChunkPriorityView());
+
+		m_prevCameraPosChunkSpace = cameraPosChunkSpace;
+		m_chunkPriorityRefreshTimer = 0.0f;
+	}
+	else
+	{
+		m_chunkPriorityRefreshTimer += dt;
+
+		if (m_chunkPriorityRefreshTimer >= ChunkPriorityRefreshInterval)
+		{
+			ZoneScopedN("Reprioritize Chunks");
+
+			const ChunkPriorityView view = _getChunkPriorityView();
+			m_chunkScheduler.reprioritize([this, &view](const ChunkScheduler::Request& request) {
+				return _getChunkPriority(request.position, request.lodLevel, view);
+			});
+
+			m_chunkPriorityRefreshTimer = 0.0f;
+		}
+	}
+
+	if (m_areDrawnChunksStale)
+	{
+		_updateDrawnChunks();
+	}
+
+	// From startup or a teleport, or any hole opening up while streaming, until the view is whole again.
+	if (!m_isHorizonComplete)
+	{
+		m_horizonLoadTime += dt;
+	}
+	else if (m_horizonLoadTime > 0.0f)
+	{
+		TracyPlot("Time To Complete Horizon", m_horizonLoadTime);
+		m_horizonLoadTime = 0.0f;
+	}
+
+	// Nothing around the camera after startup or a teleport. Getting the nearest chunk on screen matters 
+	// more than throughput then, so all workers build that one together while it's missing.
+	if (!_hasChunksAround(cameraPosChunkSpace))
+	{
+		_loadChunkInParallel(cameraPosChunkSpace);
+	}
+
+	_pumpChunkPipeline();
+}
+
+void World::_recycleChunkCells()
+{
+	ZoneScoped;
+
+	// A region is a whole lap of its grid along each axis, so the cells of the chunks that entered it
+	// are exactly those of the chunks that left. They start over, the rest keep their state, including
+	// any work in flight for them.
+	for (uint32_t lodLevel = 0; lodLevel <= ChunkMaxLOD; ++lodLevel)
+	{
+		for (const glm::i32vec3& position : m_enteringChunks[lodLevel])
+		{
+			const size_t cellIndex = getChunkCellIndex(position, lodLevel);
+
+			// Workers may be advancing the old chunk, a new generation makes them fail from here on.
+			std::atomic<ChunkCell>& cell = m_chunkGrid.cells[cellIndex];
+			ChunkCell current = cell.load(std::memory_order_relaxed);
+			while (!cell.compare_exchange_weak(current, makeChunkCell(getChunkCellGeneration(current) + 1, ChunkCellState_Empty), std::memory_order_acq_rel, std::memory_order_relaxed));
+
+			if (getChunkCellState(current) == ChunkCellState_Resident)
+			{
+				_removeChunk(m_chunkGrid.handles[cellIndex].load(std::memory_order_relaxed));
+			}
+		}
+	}
+}
+
+static size_t getColumnBoundsIndex(const glm::i32vec2& column)
+{
+	const int32_t size = (int32_t)DrawDistance;
+	const int32_t x = ((column.x % size) + size) % size;
+	const int32_t z = ((column.y % size) + size) % size;
+	return (size_t)(z * size + x);
+}
+
+float World::_getStreamingRadius() const
+{
+	// Whatever is past the far plane or hidden in fog can't be seen.
+	return std::min(m_camera.getFarClip(), m_fogEnd) + ChunkStreamingMargin;
+}
+
+void World::_updateColumnBounds(const glm::i32vec3& regionMin, float radius)
+{
+	ZoneScoped;
+
+	std::vector<ChunkColumnBounds*> staleColumns;
+
+	const glm::vec2 center(m_camera.getPosition().x, m_camera.getPosition().z);
+
+	for (uint32_t gz = 0; gz < DrawDistance; ++gz)
+	{
+		for (uint32_t gx = 0; gx < DrawDistance; ++gx)
+		{
+			const glm::i32vec2 column(regionMin.x + (int32_t)gx, regionMin.z + (int32_t)gz);
+
+			// Only columns the streamed sphere reaches have chunks to cull, the region's corners don't.
+			const glm::vec2 columnMin = glm::vec2(column) * (float)ChunkSideSize;
+			const glm::vec2 closest = glm::clamp(center, columnMin, columnMin + (float)ChunkSideSize);
+			if (glm::distance(closest, center) >= radius)
+			{
+				continue;
+			}
+
+			ChunkColumnBounds& bounds = m_chunkGrid.columnBounds[getColumnBoundsIndex(column)];
+			if (bounds.column == column)
+			{
+				continue;
+			}
+
+			bounds.column = column;
+			staleColumns.push_back(&bounds);
+		}
+	}
+
+	jobs::parallelFor(staleColumns.size(), 4, [&staleColumns](size_t i) {
+		ChunkColumnBounds& bounds = *staleColumns[i];
+
+		// Terrain samples with x and z swapped, see sampleChunk.
+		bounds.hasBounds = Terrain::sampleSurfaceBounds(
+			bounds.column.y * (int32_t)ChunkSideSize, 
+			bounds.column.x * (int32_t)ChunkSideSize, 
+			ChunkSideSize + 1, 
+			ChunkSideSize + 1, 
+			1.0f, 
+			&bounds.minY, 
+			&bounds.maxY);
+	});
+}
 
-        graphics::allocateAndBindDedicatedImageMemory(m_resolvedColor[i], &m_resolvedColorMemory[i]);
+bool World::_isChunkCulled(const glm::i32vec3& position) const
+{
+	const glm::i32vec2 column(position.x, position.z);
 
-        const VkImageViewCreateInfo viewInfo{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-			.image = m_resolvedColor[i],
-			.viewType = VK_IMAGE_VIEW_TYPE_2D,
-			.format = imageInfo.format,
-			.subresourceRange = {
-				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-				.levelCount = 1,
-				.layerCount = 1,
-			},
-		};
+	const ChunkColumnBounds& bounds = m_chunkGrid.columnBounds[getColumnBoundsIndex(column)];
+	assert(bounds.column == column);
 
-        if (vkCreateImageView(graphics::device, &viewInfo, nullptr, &m_resolvedColorView[i])) {
-            throw std::runtime_error("failed to create image view!");
-        }
+	if (!bounds.hasBounds)
+	{
+		return false;
+	}
 
-		const std::string name = "Resolved_Color_" + std::to_string(i);
-		graphics::setObjectDebugName(m_resolvedColor[i], name);
-		graphics::setObjectDebugName(m_resolvedColorView[i], name);
-    }
+	const float chunkMinY = (float)(position.y * (int32_t)ChunkSideSize);
+	const float chunkMaxY = chunkMinY + (float)ChunkSideSize;
 
-	m_debugRenderer.reset(new DebugRenderer(m_descriptorPool));
+	return chunkMinY > bounds.maxY || chunkMaxY < bounds.minY;
+}
+
+static float getChunkPriority(const glm::i32vec3& position, uint32_t lodLevel, const ChunkPriorityView& view)
+{
+	const glm::vec3 chunkCenter = (glm::vec3(position) + 0.5f) * (float)(ChunkSideSize << lodLevel);
 
-	const size_t gridSize = DrawDistance * DrawDistance * DrawDistance;
-	m_chunkGrid.occupation.reset(new uint8_t[gridSize]);
-	std::fill_n(m_chunkGrid.occupation.get(), gridSize, (uint8_t)0);
+	// Distance from where the camera is headed, so chunks along the flight path come first.
+	const glm::vec3 toChunk = chunkCenter - view.predictedPosition;
+	const float distanceSq = glm::dot(toChunk, toChunk);
 
-	m_chunkGrid.regionMin = glm::i32vec3(
-		0 - (DrawDistance / 2),
-		0 - (DrawDistance / 2),
-		0 - (DrawDistance / 2)
-	);
+	// Chunks the camera is looking away from can wait, except for the ones right around it.
+	const glm::vec3 fromCamera = chunkCenter - view.position;
+	const float distanceFromCamera = glm::length(fromCamera);
 
-	m_chunkGrid.regionMax = glm::i32vec3(
-		0 + (DrawDistance / 2),
-		0 + (DrawDistance / 2),
-		0 + (DrawDistance / 2)
-	);
+	float cosAngle = 1.0f;
+	if (distanceFromCamera > (float)ChunkSideSize)
+	{
+		cosAngle = glm::dot(fromCamera, view.forward) / distanceFromCamera;
+	}
+
+	const float angleScale = 1.0f + (ChunkBehindPriorityScale - 1.0f) * (1.0f - cosAngle) * 0.5f;
+	return distanceSq * angleScale * angleScale;
+}
 
-	// Init workers
-	const size_t workerCount = getCoreCount() - 1;
+float World::_getChunkPriority(const glm::i32vec3& position, uint32_t lodLevel, const ChunkPriorityView& view) const
+{
+	const float priority = getChunkPriority(position, lodLevel, view);
 
-	m_threads.resize(workerCount);
-	for (size_t i = 0; i < workerCount; ++i)
+	// Split nodes are only requested as fallbacks, all of those come first, nearest first. The rest are 
+	// never below zero.
+	const uint32_t nodeIndex = _findLodNode(position, lodLevel);
+	if (nodeIndex != NoLodNode && m_lodSelector.getNodes()[nodeIndex].childCount != 0)
 	{
-		m_threads[i] = std::thread([this, workerCount] (size_t i) {
-			_workerThreadEP(i, workerCount);
-		}, i);
+		return -1.0f / (1.0f + priority);
 	}
+
+	return priority;
 }
 
-void World::update(float dt, Input& input)
+ChunkPriorityView World::_getChunkPriorityView() const
+{
+	ChunkPriorityView view;
+	view.position = m_camera.getPosition();
+	view.predictedPosition = view.position + m_camera.getVelocity() * m_prefetchLookAhead;
+	view.forward = m_camera.getForward();
+	return view;
+}
+
+void World::_selectChunkLods(const ChunkPriorityView& priorityView)
 {
 	ZoneScoped;
 
-	TracyPlot("Chunk Count", (int64_t)m_chunks.count());
-	TracyPlot("Main Thread Work Amount", (int64_t)m_mainThreadWorkQueue.unsafe_size());
+	// Forget the previous selection, holding on to the nodes still being built to check against the new one.
+	m_inFlightLodNodes.clear();
+	for (const ChunkLodNode& node : m_lodSelector.getNodes())
+	{
+		const size_t cellIndex = getChunkCellIndex(node.position, node.lodLevel);
+		m_chunkGrid.lodNodes[cellIndex] = NoLodNode;
 
-	//m_btWorld->stepSimulation(dt);
+		if (isChunkInFlight(m_chunkGrid.cells[cellIndex].load(std::memory_order_relaxed)))
+		{
+			m_inFlightLodNodes.push_back(node);
+		}
+	}
 
-	GamepadState gamepad;
-	if (input.getGamepadState(gamepad))
+	ChunkLodView view;
+	view.position = m_camera.getPosition();
+	view.projectionScale = m_camera.getProjectionScale();
+	view.radius = _getStreamingRadius();
+
+	for (uint32_t lodLevel = 0; lodLevel <= ChunkMaxLOD; ++lodLevel)
 	{
-		static bool yButtonPrev = false;
+		view.regionMin[lodLevel] = m_chunkGrid.regionMin[lodLevel];
+		view.regionMax[lodLevel] = m_chunkGrid.regionMax[lodLevel];
+		view.averageVertexCounts[lodLevel] = m_lodChunkCounts[lodLevel] > 0 ? 
+			(float)m_lodVertexCounts[lodLevel] / (float)m_lodChunkCounts[lodLevel] : 
+			DefaultLodVertexCount;
+	}
 
-		if (gamepad.isButtonDown(GamepadButton::Y) && !yButtonPrev)
+	m_lodSelector.select(view, m_lodBudget);
+
+	const std::vector<ChunkLodNode>& nodes = m_lodSelector.getNodes();
+	for (uint32_t i = 0; i < (uint32_t)nodes.size(); ++i)
+	{
+		m_chunkGrid.lodNodes[getChunkCellIndex(nodes[i].position, nodes[i].lodLevel)] = i;
+	}
+
+	// Nodes that were merged away aren't wanted any more, nor split ones unless they are fallbacks, a new
+	// generation stops their work. Fallbacks go once their children cover them, see _updateDrawnChunks.
+	size_t cancelledCount = 0;
+	for (const ChunkLodNode& node : m_inFlightLodNodes)
+	{
+		const uint32_t nodeIndex = _findLodNode(node.position, node.lodLevel);
+		if (nodeIndex != NoLodNode && (nodes[nodeIndex].childCount == 0 || m_isProgressiveLoading))
 		{
-			m_freezeFrustum = !m_freezeFrustum;
+			continue;
 		}
 
-		yButtonPrev = gamepad.isButtonDown(GamepadButton::Y);
+		// Workers move it along meanwhile, and it may have been recycled with the region already.
+		std::atomic<ChunkCell>& cell = m_chunkGrid.cells[getChunkCellIndex(node.position, node.lodLevel)];
+		ChunkCell current = cell.load(std::memory_order_relaxed);
+		while (isChunkInFlight(current))
+		{
+			if (cell.compare_exchange_weak(current, makeChunkCell(getChunkCellGeneration(current) + 1, ChunkCellState_Empty), std::memory_order_acq_rel, std::memory_order_relaxed))
+			{
+				++cancelledCount;
+				break;
+			}
+		}
 	}
 
+	m_chunkRequests.clear();
+	size_t culledCount = 0;
+	size_t fallbackCount = 0;
+
+	auto claimChunk = [this](const glm::i32vec3& position, uint32_t lodLevel, ChunkCell current) {
+		ChunkScheduler::Request request;
+		request.position = position;
+		request.lodLevel = lodLevel;
+		// Set by the scheduler, along with everything already queued.
+		request.priority = 0.0f;
+		request.cell = makeChunkCell(getChunkCellGeneration(current), ChunkCellState_Claimed);
+
+		m_chunkGrid.cells[getChunkCellIndex(position, lodLevel)].store(request.cell, std::memory_order_release);
+		m_chunkRequests.push_back(request);
+	};
+
+	for (const ChunkLodNode& node : nodes)
 	{
-		ZoneScopedN("Perform Work");
+		if (node.childCount != 0)
+		{
+			continue;
+		}
+
+		std::atomic<ChunkCell>& cell = m_chunkGrid.cells[getChunkCellIndex(node.position, node.lodLevel)];
+		const ChunkCell current = cell.load(std::memory_order_relaxed);
+		if (getChunkCellState(current) != ChunkCellState_Empty)
+		{
+			continue;
+		}
 
-		m_stagingCopies.clear();
-		size_t chunkStagingBufferOffset = 0;
+		// Workers never touch empty cells. Only full resolution chunks line up with the column bounds.
+		if (node.lodLevel == 0 && _isChunkCulled(node.position))
+		{
+			cell.store(makeChunkCell(getChunkCellGeneration(current), ChunkCellState_Culled), std::memory_order_relaxed);
+			++culledCount;
+			continue;
+		}
 
-		bool cancelWork = false;
+		claimChunk(node.position, node.lodLevel, current);
+	}
 
-		WorkItem work;
-		while (!cancelWork && m_mainThreadWorkQueue.dequeue(work))
+	// A missing leaf with no ancestor loaded or on its way would leave a hole until it is built. A coarse 
+	// ancestor is cheap next to all the leaves it stands in for, it is drawn in their place meanwhile.
+	if (m_isProgressiveLoading)
+	{
+		for (const ChunkLodNode& node : nodes)
 		{
-			switch (work.type)
+			if (node.childCount != 0 || node.lodLevel == ChunkMaxLOD || isChunkReady(m_chunkGrid.cells[getChunkCellIndex(node.position, node.lodLevel)].load(std::memory_order_relaxed)))
 			{
-				case WorkItemType::ChunkLoaded:
-				{
-					const size_t vertexCount = work.chunkLoaded.chunkVertexCount;
-					const glm::vec3* chunkPositionBuffer = work.chunkLoaded.chunkPositionBuffer;
-					const glm::vec3* chunkNormalBuffer = work.chunkLoaded.chunkNormalBuffer;
-					const VisualChunk& vchunk = work.chunkLoaded.visualChunk;
+				continue;
+			}
 
-					assert(vchunk.vertexCount == vertexCount);
+			// Ancestors are split nodes of the selection, their cells are only ever taken by fallbacks or
+			// by chunks loaded back when they were leaves.
+			bool hasFallback = false;
+			glm::i32vec3 ancestorPosition = node.position;
+			for (uint32_t ancestorLevel = node.lodLevel + 1; ancestorLevel <= ChunkMaxLOD && !hasFallback; ++ancestorLevel)
+			{
+				ancestorPosition = ancestorPosition >> 1;
+				hasFallback = getChunkCellState(m_chunkGrid.cells[getChunkCellIndex(ancestorPosition, ancestorLevel)].load(std::memory_order_relaxed)) != ChunkCellState_Empty;
+			}
 
-					if (vchunk.vertexCount > 0) {
-						const size_t positionDataSize = vertexCount * sizeof(glm::vec3);
-						const size_t normalDataSize = vertexCount * sizeof(glm::vec3);
-						const size_t totalDataSize = positionDataSize + normalDataSize;
+			if (hasFallback)
+			{
+				continue;
+			}
 
-						const size_t vertexDataOffset = 0;
-						const size_t normalDataOffset = positionDataSize;
+			const uint32_t fallbackLevel = std::min(node.lodLevel + ChunkFallbackLevelCount, ChunkMaxLOD);
+			const glm::i32vec3 fallbackPosition = node.position >> (int32_t)(fallbackLevel - node.lodLevel);
+			claimChunk(fallbackPosition, fallbackLevel, m_chunkGrid.cells[getChunkCellIndex(fallbackPosition, fallbackLevel)].load(std::memory_order_relaxed));
+			++fallbackCount;
+		}
+	}
 
-						if ((chunkStagingBufferOffset + totalDataSize) > m_chunkStagingBufferSize) {
-							cancelWork = true;
-							break;
-						}
+	// Requests for cells that have since been recycled or cancelled would only be turned away by the workers.
+	const std::atomic<ChunkCell>* cells = m_chunkGrid.cells.get();
+	m_chunkScheduler.merge(m_chunkRequests, 
+		[cells](const ChunkScheduler::Request& request) {
+			return cells[getChunkCellIndex(request.position, request.lodLevel)].load(std::memory_order_relaxed) == request.cell;
+		},
+		[this, &priorityView](const ChunkScheduler::Request& request) {
+			return _getChunkPriority(request.position, request.lodLevel, priorityView);
+		});
+
+	TracyPlot("Cancelled Chunk Count", (int64_t)cancelledCount);
+	TracyPlot("Culled Chunk Count", (int64_t)culledCount);
+	TracyPlot("Fallback Chunk Count", (int64_t)fallbackCount);
+
+	m_isLodSelectionStale = false;
+	m_areDrawnChunksStale = true;
+}
 
-						uint8_t* mappedMemory = ((uint8_t*)m_chunkStagingBufferData[m_frameIndex]) + chunkStagingBufferOffset;
+uint32_t World::_findLodNode(const glm::i32vec3& position, uint32_t lodLevel) const
+{
+	// The cell is shared by every coordinate DrawDistance apart.
+	const uint32_t nodeIndex = m_chunkGrid.lodNodes[getChunkCellIndex(position, lodLevel)];
+	if (nodeIndex == NoLodNode || m_lodSelector.getNodes()[nodeIndex].position != position)
+	{
+		return NoLodNode;
+	}
 
-						memcpy(mappedMemory + vertexDataOffset, chunkPositionBuffer, positionDataSize);
-						memcpy(mappedMemory + normalDataOffset, chunkNormalBuffer, normalDataSize);
+	return nodeIndex;
+}
 
-						StagingCopy copy{};
+uint32_t World::_findLodLeaf(const glm::i32vec3& position) const
+{
+	// Down from the root over a full resolution chunk coordinate, shifts floor negative coordinates too.
+	for (uint32_t lodLevel = ChunkMaxLOD + 1; lodLevel-- > 0;)
+	{
+		const uint32_t nodeIndex = _findLodNode(position >> (int32_t)lodLevel, lodLevel);
+		if (nodeIndex == NoLodNode)
+		{
+			return NoLodNode;
+		}
 
-						copy.size = positionDataSize;
-						copy.dstBuffer = vchunk.vertexBuffer;
-						copy.srcOffset = chunkStagingBufferOffset + vertexDataOffset;
-						m_stagingCopies.push_back(copy);
+		if (m_lodSelector.getNodes()[nodeIndex].childCount == 0)
+		{
+			return nodeIndex;
+		}
+	}
 
-						copy.size = normalDataSize;
-						copy.dstBuffer = vchunk.normalBuffer;
-						copy.srcOffset = chunkStagingBufferOffset + normalDataOffset;
-						m_stagingCopies.push_back(copy);
+	return NoLodNode;
+}
 
-						chunkStagingBufferOffset += totalDataSize;
-					}
+void World::_updateDrawnChunks()
+{
+	ZoneScoped;
 
-					delete[] chunkPositionBuffer;
-					delete[] chunkNormalBuffer;
+	const std::vector<ChunkLodNode>& nodes = m_lodSelector.getNodes();
+	m_lodNodeStates.resize(nodes.size());
 
-					ChunkHandle chunkHandle = m_chunks.add();
-					const uint32_t chunkIndex = m_chunks.lookup(chunkHandle);
+	// Children come after their parents, going backwards sees all of them before the parent.
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		const ChunkLodNode& node = nodes[i];
+		LodNodeState& state = m_lodNodeStates[i];
 
-					m_chunks.visuals[chunkIndex] = work.chunkLoaded.visualChunk;
-					m_chunks.positions[chunkIndex] = work.chunkLoaded.position;
+		if (node.childCount == 0)
+		{
+			state.isCovered = isChunkReady(m_chunkGrid.cells[getChunkCellIndex(node.position, node.lodLevel)].load(std::memory_order_relaxed));
+			continue;
+		}
 
-					// Set AABB
-					/*m_chunks.boundingBoxes[chunkIndex].Center.x = (float)(work.chunkLoaded.position.x * (int32_t)ChunkSideSize);
-					m_chunks.boundingBoxes[chunkIndex].Center.y = (float)(work.chunkLoaded.position.y * (int32_t)ChunkSideSize);
-					m_chunks.boundingBoxes[chunkIndex].Center.z = (float)(work.chunkLoaded.position.z * (int32_t)ChunkSideSize);
-					m_chunks.boundingBoxes[chunkIndex].Extents.x = (float)ChunkSideSize;
-					m_chunks.boundingBoxes[chunkIndex].Extents.y = (float)ChunkSideSize;
-					m_chunks.boundingBoxes[chunkIndex].Extents.z = (float)ChunkSideSize;*/
+		state.isCovered = true;
+		for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+		{
+			state.isCovered = state.isCovered && m_lodNodeStates[child].isCovered;
+		}
 
-					break;
-				}
-			}
+		if (!state.isCovered)
+		{
+			continue;
 		}
 
-		TracyPlot("Staging Buffer Usage", (int64_t)chunkStagingBufferOffset)
+		// A fallback still being built is too late, a new generation stops its work.
+		std::atomic<ChunkCell>& cell = m_chunkGrid.cells[getChunkCellIndex(node.position, node.lodLevel)];
+		ChunkCell current = cell.load(std::memory_order_relaxed);
+		while (isChunkInFlight(current) && !cell.compare_exchange_weak(current, makeChunkCell(getChunkCellGeneration(current) + 1, ChunkCellState_Empty), std::memory_order_acq_rel, std::memory_order_relaxed));
 	}
 
-	m_camera.update(input, dt);
-
-	const glm::vec3& cameraPos = m_camera.getPosition();
-	const glm::i32vec3 cameraPosChunkSpace(
-		(int32_t)cameraPos.x / (int32_t)ChunkSideSize,
-		(int32_t)cameraPos.y / (int32_t)ChunkSideSize,
-		(int32_t)cameraPos.z / (int32_t)ChunkSideSize
-	);
+	for (size_t i = 0; i < m_lodSelector.getRootCount(); ++i)
+	{
+		m_lodNodeStates[i].isHidden = false;
+	}
 
-	if (cameraPosChunkSpace.x != m_prevCameraPosChunkSpace.x || 
-		cameraPosChunkSpace.y != m_prevCameraPosChunkSpace.y ||
-		cameraPosChunkSpace.z != m_prevCameraPosChunkSpace.z)
+	// A leaf is drawn once it is loaded. Until all of a split node's children are, the node stays in
+	// their place if it is still resident.
+	for (size_t i = 0; i < nodes.size(); ++i)
 	{
-		ZoneScopedN("Update Grid");
-		
-		m_gridMutex.lock();
+		const ChunkLodNode& node = nodes[i];
+		LodNodeState& state = m_lodNodeStates[i];
+
+		const bool isResident = getChunkCellState(m_chunkGrid.cells[getChunkCellIndex(node.position, node.lodLevel)].load(std::memory_order_relaxed)) == ChunkCellState_Resident;
+		state.isDrawn = !state.isHidden && isResident && (node.childCount == 0 || !state.isCovered);
+
+		for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+		{
+			m_lodNodeStates[child].isHidden = state.isHidden || state.isDrawn;
+		}
+	}
 
-		m_chunkGrid.regionMin = glm::i32vec3(
-			cameraPosChunkSpace.x - (DrawDistance / 2),
-			cameraPosChunkSpace.y - (DrawDistance / 2),
-			cameraPosChunkSpace.z - (DrawDistance / 2)
-		);
+	// A ready leaf is either drawn or hidden under something that is, culled ones have nothing to draw.
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		const ChunkLodNode& node = nodes[i];
+		LodNodeState& state = m_lodNodeStates[i];
 
-		m_chunkGrid.regionMax = glm::i32vec3(
-			cameraPosChunkSpace.x + (DrawDistance / 2),
-			cameraPosChunkSpace.y + (DrawDistance / 2),
-			cameraPosChunkSpace.z + (DrawDistance / 2)
-		);
+		if (node.childCount == 0)
+		{
+			state.isShown = state.isCovered;
+			continue;
+		}
 
+		state.isShown = true;
+		for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; ++child)
 		{
-			// Mark which tiles are occupied.
+			state.isShown = state.isShown && m_lodNodeStates[child].isShown;
+		}
+		state.isShown = state.isShown || state.isDrawn;
+	}
 
-			ZoneScopedN("Mark Occupation And Remove");
+	m_isHorizonComplete = true;
+	for (size_t i = 0; i < m_lodSelector.getRootCount(); ++i)
+	{
+		m_isHorizonComplete = m_isHorizonComplete && m_lodNodeStates[i].isShown;
+	}
 
-			const size_t gridSize = DrawDistance * DrawDistance * DrawDistance;
-			std::fill_n(m_chunkGrid.occupation.get(), gridSize, (uint8_t)0);
+	++m_drawnChunksUpdateIndex;
 
-			for (size_t chunkIt = 0; chunkIt < m_chunks.count();)
-			{
-				const glm::i32vec3& position = m_chunks.positions[chunkIt];
-				
-				if (position.x >= m_chunkGrid.regionMin.x &&
-					position.y >= m_chunkGrid.regionMin.y &&
-					position.z >= m_chunkGrid.regionMin.z &&
-					position.x < m_chunkGrid.regionMax.x &&
-					position.y < m_chunkGrid.regionMax.y &&
-					position.z < m_chunkGrid.regionMax.z)
-				{
-					const glm::i32vec3 occupationPos(
-						position.x - m_chunkGrid.regionMin.x, 
-						position.y - m_chunkGrid.regionMin.y,
-						position.z - m_chunkGrid.regionMin.z
-					);
+	const glm::vec3& cameraPos = m_camera.getPosition();
+	const float unloadRadius = _getStreamingRadius() + ChunkUnloadMargin;
 
-					const int occupationIndex = (occupationPos.z * DrawDistance * DrawDistance) + (occupationPos.y * DrawDistance) + occupationPos.x;
-					assert(occupationIndex < gridSize);
-					m_chunkGrid.occupation[occupationIndex] = 1;
+	size_t drawnCount = 0;
+	size_t retiredCount = 0;
+	size_t retainedBytes = 0;
+	m_retainedChunks.clear();
 
-					++chunkIt;
-				}
-				else
+	for (uint32_t chunkIndex = 0; chunkIndex < (uint32_t)m_chunks.count();)
+	{
+		const glm::i32vec3 position = m_chunks.positions[chunkIndex];
+		const uint32_t lodLevel = m_chunks.lodLevels[chunkIndex];
+
+		bool isWanted = false;
+		bool isDrawn = false;
+
+		const uint32_t nodeIndex = _findLodNode(position, lodLevel);
+		if (nodeIndex != NoLodNode)
+		{
+			// A split node is only kept until its children cover it.
+			isWanted = nodes[nodeIndex].childCount == 0 || !m_lodNodeStates[nodeIndex].isCovered;
+			isDrawn = m_lodNodeStates[nodeIndex].isDrawn;
+		}
+		else
+		{
+			// Merged away, or out of range. It is kept in the place of the leaf above it while that 
+			// one loads, unless a coarser chunk in between already is.
+			bool isCoveredInBetween = false;
+			glm::i32vec3 ancestorPosition = position;
+			for (uint32_t ancestorLevel = lodLevel + 1; ancestorLevel <= ChunkMaxLOD; ++ancestorLevel)
+			{
+				ancestorPosition = ancestorPosition >> 1;
+
+				const uint32_t ancestorIndex = _findLodNode(ancestorPosition, ancestorLevel);
+				if (ancestorIndex != NoLodNode)
 				{
-					ChunkHandle handle = m_chunks.reverseLookup(static_cast<uint32_t>(chunkIt));
-					m_chunks.remove(handle);
+					const ChunkLodNode& ancestor = nodes[ancestorIndex];
+					const LodNodeState& ancestorState = m_lodNodeStates[ancestorIndex];
+
+					isWanted = ancestor.childCount == 0 && !ancestorState.isCovered;
+					isDrawn = isWanted && !ancestorState.isHidden && !isCoveredInBetween;
+					break;
 				}
+
+				const size_t ancestorCellIndex = getChunkCellIndex(ancestorPosition, ancestorLevel);
+				isCoveredInBetween = isCoveredInBetween || (
+					getChunkCellState(m_chunkGrid.cells[ancestorCellIndex].load(std::memory_order_relaxed)) == ChunkCellState_Resident &&
+					m_chunkGrid.positions[ancestorCellIndex].load(std::memory_order_relaxed) == packChunkPosition(ancestorPosition));
 			}
 		}
 
-		m_gridMutex.unlock();
+		if (isWanted)
+		{
+			m_chunks.lastWanted[chunkIndex] = m_drawnChunksUpdateIndex;
+		}
+		else if (getLodNodeDistance(cameraPos, position, lodLevel) < unloadRadius)
+		{
+			// Hidden in its cell, the selection finds it resident if it wants it back.
+			m_retainedChunks.push_back(m_chunks.reverseLookup(chunkIndex));
+			retainedBytes += getChunkUploadSize(m_chunks.visuals[chunkIndex].vertexCount);
+		}
+		else
+		{
+			// The last chunk is moved into its place, look at the same index again.
+			_evictChunk(m_chunks.reverseLookup(chunkIndex));
+			++retiredCount;
+			continue;
+		}
+
+		m_chunks.isDrawn[chunkIndex] = isDrawn;
+		drawnCount += isDrawn ? 1 : 0;
+		++chunkIndex;
+	}
 
-		m_prevCameraPosChunkSpace = cameraPosChunkSpace;
+	// Least recently wanted first, until the rest fit.
+	if (retainedBytes > m_retainedChunkBudget)
+	{
+		std::sort(m_retainedChunks.begin(), m_retainedChunks.end(), [this](ChunkHandle a, ChunkHandle b) {
+			return m_chunks.lastWanted[m_chunks.lookup(a)] < m_chunks.lastWanted[m_chunks.lookup(b)];
+		});
+
+		for (size_t i = 0; i < m_retainedChunks.size() && retainedBytes > m_retainedChunkBudget; ++i)
+		{
+			retainedBytes -= getChunkUploadSize(m_chunks.visuals[m_chunks.lookup(m_retainedChunks[i])].vertexCount);
+			_evictChunk(m_retainedChunks[i]);
+			++retiredCount;
+		}
+	}
+
+	TracyPlot("Drawn Chunk Count", (int64_t)drawnCount);
+	TracyPlot("Retired Chunk Count", (int64_t)retiredCount);
+	TracyPlot("Retained Chunk Bytes", (int64_t)retainedBytes);
+
+	m_areDrawnChunksStale = false;
+}
+
+void World::_evictChunk(ChunkHandle handle)
+{
+	const uint32_t chunkIndex = m_chunks.lookup(handle);
+
+	// findChunk sees the new generation before the handle goes, nothing else touches resident cells.
+	std::atomic<ChunkCell>& cell = m_chunkGrid.cells[getChunkCellIndex(m_chunks.positions[chunkIndex], m_chunks.lodLevels[chunkIndex])];
+	cell.store(makeChunkCell(getChunkCellGeneration(cell.load(std::memory_order_relaxed)) + 1, ChunkCellState_Empty), std::memory_order_release);
+
+	_removeChunk(handle);
+}
+
+void World::_removeChunk(ChunkHandle handle)
+{
+	const uint32_t chunkIndex = m_chunks.lookup(handle);
+	const uint32_t lodLevel = m_chunks.lodLevels[chunkIndex];
+
+	m_lodVertexCounts[lodLevel] -= m_chunks.visuals[chunkIndex].vertexCount;
+	m_lodChunkCounts[lodLevel] -= 1;
+	m_areDrawnChunksStale = true;
+
+	m_chunks.remove(handle);
+}
+
+static glm::vec4 getMatrixRow(const glm::mat4& m, int row)
+{
+	return glm::vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+}
+
+size_t World::_countVisibleMissingChunks() const
+{
+	ZoneScoped;
+
+	// Frustum planes pointing inwards, see "Fast Extraction of Viewing Frustum Planes from the 
+	// World-View-Projection Matrix" (Gribb, Hartmann 2001).
+	const glm::mat4& worldToNDC = m_camera.getWorldToNDCMatrix();
+	const glm::vec4 row0 = getMatrixRow(worldToNDC, 0);
+	const glm::vec4 row1 = getMatrixRow(worldToNDC, 1);
+	const glm::vec4 row2 = getMatrixRow(worldToNDC, 2);
+	const glm::vec4 row3 = getMatrixRow(worldToNDC, 3);
+
+	const glm::vec4 planes[6] = {
+		row3 + row0,
+		row3 - row0,
+		row3 + row1,
+		row3 - row1,
+		row3 + row2,
+		row3 - row2,
+	};
+
+	// The selection only has nodes within the far plane, everything past it is fogged out.
+	size_t missingCount = 0;
+
+	for (const ChunkLodNode& node : m_lodSelector.getNodes())
+	{
+		if (node.childCount != 0 || !isChunkInFlight(m_chunkGrid.cells[getChunkCellIndex(node.position, node.lodLevel)].load(std::memory_order_relaxed)))
+		{
+			continue;
+		}
+
+		const float nodeSize = (float)(ChunkSideSize << node.lodLevel);
+		const glm::vec3 boxMin = glm::vec3(node.position) * nodeSize;
+		const glm::vec3 boxMax = boxMin + nodeSize;
+
+		bool isVisible = true;
+		for (const glm::vec4& plane : planes)
+		{
+			// The corner furthest along the plane normal.
+			const glm::vec3 corner(
+				plane.x >= 0.0f ? boxMax.x : boxMin.x,
+				plane.y >= 0.0f ? boxMax.y : boxMin.y,
+				plane.z >= 0.0f ? boxMax.z : boxMin.z);
+
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			{
+				isVisible = false;
+				break;
+			}
+		}
+
+		if (isVisible)
+		{
+			++missingCount;
+		}
 	}
+
+	return missingCount;
 }
 
 inline void XM_CALLCONV CreateBoundingFrustumRH(BoundingFrustum& Out, FXMMATRIX Projection)
@@ -1181,7 +2649,14 @@ void World::draw()
 	else
 #endif
 	{
-		std::fill(cullingBitset.begin(), cullingBitset.end(), (uint64_t)-1);
+		// Only the chunks the LOD selection picked, the rest are other levels of the same terrain.
+		std::fill(cullingBitset.begin(), cullingBitset.end(), (uint64_t)0);
+
+		for (size_t chunkIt = 0; chunkIt < m_chunks.count(); ++chunkIt)
+		{
+			const uint64_t isDrawn = m_chunks.isDrawn[chunkIt] ? 1 : 0;
+			cullingBitset[chunkIt / 64] |= isDrawn << (chunkIt % 64);
+		}
 	}
 
 	{
@@ -1206,8 +2681,8 @@ void World::draw()
 
 		{
 			TerrainConstantBuffer uniforms{};
-			uniforms.u_fogStart = 32.0f;
-			uniforms.u_fogEnd = m_camera.getFarClip();
+			uniforms.u_fogStart = m_fogStart;
+			uniforms.u_fogEnd = m_fogEnd;
 			uniforms.u_fogRangeInv = 1.0f / (uniforms.u_fogEnd - uniforms.u_fogStart);
 			uniforms.u_fogColor.x = 0.0f;
 			uniforms.u_fogColor.y = 0.0f;
@@ -1668,509 +3143,6 @@ void World::resizeBuffers(uint32_t /*width*/, uint32_t /*height*/)
 	m_depthBuffers[1] = renderer.createTexture2D(depthBufferDesc); */
 }
 
-/*
-Linearly interpolate the position where an isosurface cuts
-an edge between two vertices, each with their own scalar value
-*/
-static glm::vec3 vertexInterp(
-	float isolevel, 
-	glm::vec3 p1,
-	glm::vec3 p2,
-	float valp1, 
-	float valp2)
-{
-	if (abs(isolevel - valp1) < 0.00001f)
-		return(p1);
-	if (abs(isolevel - valp2) < 0.00001f)
-		return(p2);
-	if (abs(valp1 - valp2) < 0.00001f)
-		return(p1);
-
-	float mu = (isolevel - valp1) / (valp2 - valp1);
-
-	glm::vec3 p;
-	p.x = p1.x + mu * (p2.x - p1.x);
-	p.y = p1.y + mu * (p2.y - p1.y);
-	p.z = p1.z + mu * (p2.z - p1.z);
-	return(p);
-}
-
-struct GridCell
-{
-	glm::vec3 p[8];
-	float val[8];
-};
-
-/*
-Given a grid cell and an isolevel, calculate the triangular
-facets required to represent the isosurface through the cell.
-Return the number of triangular facets, the array "triangles"
-will be loaded up with the vertices at most 5 triangular facets.
-0 will be returned if the grid cell is either totally above
-of totally below the isolevel.
-*/
-static void polygonise(
-	GridCell grid, 
-	float isolevel, 
-	std::vector<glm::vec3>& vertices,
-	std::vector<glm::vec3>& normals)
-{
-	constexpr int edgeTable[256] = {
-		0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
-		0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
-		0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
-		0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
-		0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
-		0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
-		0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
-		0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
-		0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
-		0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
-		0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
-		0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
-		0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
-		0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
-		0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
-		0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
-		0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
-		0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
-		0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
-		0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
-		0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
-		0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
-		0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
-		0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
-		0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
-		0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
-		0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
-		0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
-		0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
-		0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
-		0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
-		0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0 
-	};
-
-	constexpr int triTable[256][16] =
-	{ 
-		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
-		{ 8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1 },
-		{ 3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1 },
-		{ 4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
-		{ 4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1 },
-		{ 9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1 },
-		{ 10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1 },
-		{ 5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
-		{ 5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1 },
-		{ 8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1 },
-		{ 2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
-		{ 2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1 },
-		{ 11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1 },
-		{ 5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1 },
-		{ 11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1 },
-		{ 11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1 },
-		{ 2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1 },
-		{ 6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
-		{ 3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1 },
-		{ 6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
-		{ 6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1 },
-		{ 8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1 },
-		{ 7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1 },
-		{ 3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
-		{ 0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1 },
-		{ 9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1 },
-		{ 8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
-		{ 5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1 },
-		{ 0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1 },
-		{ 6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1 },
-		{ 10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
-		{ 1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1 },
-		{ 0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1 },
-		{ 3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
-		{ 6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1 },
-		{ 9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1 },
-		{ 8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1 },
-		{ 3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1 },
-		{ 10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1 },
-		{ 10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
-		{ 2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1 },
-		{ 7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
-		{ 2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1 },
-		{ 1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1 },
-		{ 11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1 },
-		{ 8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1 },
-		{ 0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1 },
-		{ 7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1 },
-		{ 7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1 },
-		{ 10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1 },
-		{ 0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1 },
-		{ 7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1 },
-		{ 6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1 },
-		{ 4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1 },
-		{ 10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1 },
-		{ 8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1 },
-		{ 1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1 },
-		{ 10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1 },
-		{ 10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1 },
-		{ 9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1 },
-		{ 7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1 },
-		{ 3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1 },
-		{ 7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1 },
-		{ 3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1 },
-		{ 6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1 },
-		{ 9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1 },
-		{ 1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1 },
-		{ 4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1 },
-		{ 7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1 },
-		{ 6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1 },
-		{ 0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1 },
-		{ 6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1 },
-		{ 0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1 },
-		{ 11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1 },
-		{ 6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1 },
-		{ 5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1 },
-		{ 9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1 },
-		{ 1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1 },
-		{ 10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1 },
-		{ 0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1 },
-		{ 11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1 },
-		{ 9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1 },
-		{ 7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1 },
-		{ 2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1 },
-		{ 9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1 },
-		{ 9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1 },
-		{ 1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1 },
-		{ 0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1 },
-		{ 10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1 },
-		{ 2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1 },
-		{ 0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1 },
-		{ 0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1 },
-		{ 9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1 },
-		{ 5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1 },
-		{ 5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1 },
-		{ 8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1 },
-		{ 9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1 },
-		{ 1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1 },
-		{ 3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1 },
-		{ 4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1 },
-		{ 9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1 },
-		{ 11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1 },
-		{ 2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1 },
-		{ 9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1 },
-		{ 3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1 },
-		{ 1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1 },
-		{ 4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1 },
-		{ 0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1 },
-		{ 1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 } 
-	};
-
-	/*
-	Determine the index into the edge table which
-	tells us which vertices are inside of the surface
-	*/
-	int cubeindex = 0;
-	if (grid.val[0] < isolevel) cubeindex |= 1;
-	if (grid.val[1] < isolevel) cubeindex |= 2;
-	if (grid.val[2] < isolevel) cubeindex |= 4;
-	if (grid.val[3] < isolevel) cubeindex |= 8;
-	if (grid.val[4] < isolevel) cubeindex |= 16;
-	if (grid.val[5] < isolevel) cubeindex |= 32;
-	if (grid.val[6] < isolevel) cubeindex |= 64;
-	if (grid.val[7] < isolevel) cubeindex |= 128;
-
-	/* Cube is entirely in/out of the surface */
-	if (edgeTable[cubeindex] == 0)
-		return;
-
-	/* Find the vertices where the surface intersects the cube */
-	glm::vec3 vertlist[12];
-	if (edgeTable[cubeindex] & 1)
-		vertlist[0] = vertexInterp(isolevel, grid.p[0], grid.p[1], grid.val[0], grid.val[1]);
-	if (edgeTable[cubeindex] & 2)
-		vertlist[1] = vertexInterp(isolevel, grid.p[1], grid.p[2], grid.val[1], grid.val[2]);
-	if (edgeTable[cubeindex] & 4)
-		vertlist[2] = vertexInterp(isolevel, grid.p[2], grid.p[3], grid.val[2], grid.val[3]);
-	if (edgeTable[cubeindex] & 8)
-		vertlist[3] = vertexInterp(isolevel, grid.p[3], grid.p[0], grid.val[3], grid.val[0]);
-	if (edgeTable[cubeindex] & 16)
-		vertlist[4] = vertexInterp(isolevel, grid.p[4], grid.p[5], grid.val[4], grid.val[5]);
-	if (edgeTable[cubeindex] & 32)
-		vertlist[5] = vertexInterp(isolevel, grid.p[5], grid.p[6], grid.val[5], grid.val[6]);
-	if (edgeTable[cubeindex] & 64)
-		vertlist[6] = vertexInterp(isolevel, grid.p[6], grid.p[7], grid.val[6], grid.val[7]);
-	if (edgeTable[cubeindex] & 128)
-		vertlist[7] = vertexInterp(isolevel, grid.p[7], grid.p[4], grid.val[7], grid.val[4]);
-	if (edgeTable[cubeindex] & 256)
-		vertlist[8] = vertexInterp(isolevel, grid.p[0], grid.p[4], grid.val[0], grid.val[4]);
-	if (edgeTable[cubeindex] & 512)
-		vertlist[9] = vertexInterp(isolevel, grid.p[1], grid.p[5], grid.val[1], grid.val[5]);
-	if (edgeTable[cubeindex] & 1024)
-		vertlist[10] = vertexInterp(isolevel, grid.p[2], grid.p[6], grid.val[2], grid.val[6]);
-	if (edgeTable[cubeindex] & 2048)
-		vertlist[11] = vertexInterp(isolevel, grid.p[3], grid.p[7], grid.val[3], grid.val[7]);
-
-	/* Create the triangle */
-	for (int i = 0; triTable[cubeindex][i] != -1; i += 3)
-	{
-		const glm::vec3& v0 = vertlist[triTable[cubeindex][i]];
-		const glm::vec3& v1 = vertlist[triTable[cubeindex][i + 1]];
-		const glm::vec3& v2 = vertlist[triTable[cubeindex][i + 2]];
-
-		glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-		vertices.push_back(v0);
-		vertices.push_back(v1);
-		vertices.push_back(v2);
-
-		normals.push_back(normal);
-		normals.push_back(normal);
-		normals.push_back(normal);
-	}
-}
-
-void initChunkBuffers(
-	uint32_t lodLevel,
-	const glm::i32vec3& origin,
-	glm::vec3** outPositions,
-	glm::vec3** outNormals,
-	size_t* outVertexCount)
-{
-	ZoneScoped;
-
-	const uint32_t lodSideSize = ChunkSideSize >> lodLevel;
-	const uint32_t lodBlockCount = lodSideSize * lodSideSize * lodSideSize;
-	const float sizeMultiplier = (float)(1 << lodLevel);
-
-	const uint32_t sampleGridSideSize = lodSideSize + 1;
-	const uint32_t sampleCount = sampleGridSideSize * sampleGridSideSize * sampleGridSideSize;
-
-	// TODO: consider using bitmask if we want to skip the intersection point approximation in the triangulation
-	std::unique_ptr<float[]> terrainSamples(new float[sampleCount]);
-
-	{
-		ZoneScopedN("Sample Terrain");
-
-		const int32_t x = origin.z * (int32_t)lodSideSize;
-		const int32_t y = origin.y * (int32_t)lodSideSize;
-		const int32_t z = origin.x * (int32_t)lodSideSize;
-
-		Terrain::sample(terrainSamples.get(), x, y, z, sampleGridSideSize, sampleGridSideSize, sampleGridSideSize, sizeMultiplier);
-	}
-
-	{
-		ZoneScopedN("Triangulate");
-
-		std::vector<glm::vec3> vertices;
-		std::vector<glm::vec3> normals;
-
-		vertices.reserve(lodBlockCount * 3);
-		normals.reserve(lodBlockCount * 3);
-
-		const uint32_t terrainSampleOffsetX = 1;
-		const uint32_t terrainSampleOffsetY = sampleGridSideSize;
-		const uint32_t terrainSampleOffsetZ = sampleGridSideSize * sampleGridSideSize;
-
-		for (uint32_t i = 0; i < lodBlockCount; ++i)
-		{
-			const uint32_t ix = (i % lodSideSize);
-			const uint32_t iy = (i / lodSideSize) % lodSideSize;
-			const uint32_t iz = (i / lodSideSize) / lodSideSize;
-
-			const float fl = sizeMultiplier;
-			const float fx = (float)origin.x * (int32_t)ChunkSideSize + ix * sizeMultiplier;
-			const float fy = (float)origin.y * (int32_t)ChunkSideSize + iy * sizeMultiplier;
-			const float fz = (float)origin.z * (int32_t)ChunkSideSize + iz * sizeMultiplier;
-
-			GridCell grid;
-			grid.p[0] = glm::vec3(fx,      fy,      fz);
-			grid.p[1] = glm::vec3(fx + fl, fy,      fz);
-			grid.p[2] = glm::vec3(fx + fl, fy + fl, fz);
-			grid.p[3] = glm::vec3(fx,      fy + fl, fz);
-			grid.p[4] = glm::vec3(fx,      fy,      fz + fl);
-			grid.p[5] = glm::vec3(fx + fl, fy,      fz + fl);
-			grid.p[6] = glm::vec3(fx + fl, fy + fl, fz + fl);
-			grid.p[7] = glm::vec3(fx,      fy + fl, fz + fl);
-
-			const uint32_t terrainSampleIndex = (iz * sampleGridSideSize * sampleGridSideSize) + (iy * sampleGridSideSize) + ix;
-
-			grid.val[0] = terrainSamples[terrainSampleIndex];
-			grid.val[1] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX];
-			grid.val[2] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX + terrainSampleOffsetY];
-			grid.val[3] = terrainSamples[terrainSampleIndex +                        terrainSampleOffsetY];
-			grid.val[4] = terrainSamples[terrainSampleIndex +                                               terrainSampleOffsetZ];
-			grid.val[5] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX +                        terrainSampleOffsetZ];
-			grid.val[6] = terrainSamples[terrainSampleIndex + terrainSampleOffsetX + terrainSampleOffsetY + terrainSampleOffsetZ];
-			grid.val[7] = terrainSamples[terrainSampleIndex +                        terrainSampleOffsetY + terrainSampleOffsetZ];
-
-			polygonise(grid, 0.0, vertices, normals);
-		}
-
-		const auto vertexCount = vertices.size();
-
-		*outVertexCount = vertexCount;
-
-		if (vertexCount > 0) 
-		{
-			*outPositions = new glm::vec3[vertexCount];
-			*outNormals = new glm::vec3[vertexCount];
-
-			memcpy(*outPositions, vertices.data(), vertexCount * sizeof(glm::vec3));
-			memcpy(*outNormals, normals.data(), vertexCount * sizeof(glm::vec3));
-		}
-		else 
-		{
-			*outPositions = nullptr;
-			*outNormals = nullptr;
-		}
-	}
-}
-
 void World::_initVisualChunk(
 	VisualChunk& vchunk,
 	size_t vertexCount)
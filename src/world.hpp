@@ -4,12 +4,18 @@
 #include <input.hpp>
 #include <graphics.hpp>
 #include <chunks.hpp>
+#include <chunk_scheduler.hpp>
+#include <chunk_lod.hpp>
+#include <chunk_request.hpp>
+#include <generation_throttle.hpp>
+#include <jobs.hpp>
 #include <debug_renderer.hpp>
 #include <descriptor_set_cache.hpp>
 
 #include <vk_mem_alloc.hpp>
 
 #include <mpmc_bounded_queue.hpp>
+#include <spsc_bounded_queue.hpp>
 #include <tracy/Tracy.hpp>
 
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
@@ -23,16 +29,89 @@
 #include <cinttypes>
 #include <vector>
 #include <atomic>
-#include <thread>
-#include <concurrent_unordered_map.h>
 #include <mutex>
-#include <shared_mutex>
+
+// Where a chunk of the streaming region is on its way to being drawn. Cells only move forward, with 
+// a compare and swap, so a chunk is built by whoever claims it and nobody else.
+enum ChunkCellState : uint8_t
+{
+	ChunkCellState_Empty = 0,
+	// Provably entirely above or below the surface, never sent to a worker.
+	ChunkCellState_Culled,
+	// Queued in the chunk scheduler, not yet taken by a worker.
+	ChunkCellState_Claimed,
+	ChunkCellState_Generating,
+	// Built and waiting for its turn in the staging buffer.
+	ChunkCellState_Uploading,
+	ChunkCellState_Resident,
+};
+
+// A cell's state in the low byte and, above it, how many times the cell has been handed to another 
+// chunk. A worker still holding on to a chunk that has left the region fails its compare and swap 
+// instead of touching whatever chunk has the cell now.
+typedef uint32_t ChunkCell;
+
+inline ChunkCell makeChunkCell(uint32_t generation, ChunkCellState state)
+{
+	return (generation << 8) | state;
+}
+
+inline ChunkCellState getChunkCellState(ChunkCell cell)
+{
+	return (ChunkCellState)(cell & 0xff);
+}
+
+inline uint32_t getChunkCellGeneration(ChunkCell cell)
+{
+	return cell >> 8;
+}
+
+struct ChunkColumnBounds
+{
+	glm::i32vec2 column;
+	float minY;
+	float maxY;
+	bool hasBounds;
+};
 
 struct ChunkGrid
 {
-	std::unique_ptr<uint8_t[]> occupation;
-	glm::i32vec3 regionMin;
-	glm::i32vec3 regionMax;
+	// One grid per LOD level, each with its own region around the camera in nodes of that level. Indexed
+	// by level and node coordinate modulo DrawDistance, a chunk keeps its cell for as long as it stays in
+	// the region. Workers advance the cells of the chunks they build, everything else is main thread only.
+	std::unique_ptr<std::atomic<ChunkCell>[]> cells;
+	// The chunk drawn for each resident cell and its packed coordinate, see packChunkPosition. Written
+	// before the cell becomes resident and left alone until it has stopped being, findChunk reads them
+	// without locking by checking the cell didn't change meanwhile.
+	std::unique_ptr<std::atomic<ChunkHandle>[]> handles;
+	std::unique_ptr<std::atomic<uint64_t>[]> positions;
+	glm::i32vec3 regionMin[ChunkMaxLOD + 1];
+	glm::i32vec3 regionMax[ChunkMaxLOD + 1];
+
+	// Where each cell's node is in the current LOD selection, if it is in it. Main thread only.
+	std::unique_ptr<uint32_t[]> lodNodes;
+
+	// Surface height band per LOD 0 chunk column, indexed by column coordinate modulo DrawDistance.
+	std::unique_ptr<ChunkColumnBounds[]> columnBounds;
+};
+
+enum ChunkStage : uint32_t
+{
+	ChunkStage_Sample = 0,
+	// Drops chunks without a surface crossing, they skip the remaining stages.
+	ChunkStage_Classify,
+	ChunkStage_Triangulate,
+	ChunkStage_Pack,
+	ChunkStage_Allocate,
+	ChunkStage_Count,
+};
+
+// What chunk priorities are computed from, see getChunkPriority.
+struct ChunkPriorityView
+{
+	glm::vec3 position;
+	glm::vec3 predictedPosition;
+	glm::vec3 forward;
 };
 
 class World
@@ -48,13 +127,83 @@ public:
 	void draw();
 	void resizeBuffers(uint32_t width, uint32_t height);
 
+	// How far ahead, in seconds, the camera's motion is extrapolated when ordering chunk requests.
+	void setPrefetchLookAhead(float seconds) { m_prefetchLookAhead = seconds; }
+
+	// Chunk generation backs off whenever a frame takes longer than this.
+	void setTargetFrameTime(float seconds) { m_generationThrottle.setTargetFrameTime(seconds); }
+
+	// Copying chunks into the staging buffer stops for the frame once it has taken this long.
+	void setUploadTimeBudget(float seconds) { m_uploadTimeBudget = seconds; }
+
+	// How fine the chunk octree is cut, and the caps on what it costs. Applied on the next update.
+	void setChunkLodBudget(const ChunkLodBudget& budget) { m_lodBudget = budget; m_isLodSelectionStale = true; }
+
+	// Terrain is drawn up to this many units away, coarser the further it is. Fog ends there too.
+	void setViewDistance(float units) { m_camera.setFarClip(units); m_fogEnd = units; m_isLodSelectionStale = true; }
+
+	// Terrain fades into the fog between start and end, nothing past the end is streamed in.
+	void setFogRange(float start, float end) { m_fogStart = start; m_fogEnd = end; m_isLodSelectionStale = true; }
+
+	// Chunks the LOD selection no longer wants stay loaded, hidden, until their vertex buffers take up
+	// more than this many bytes. Coming back to one then draws it again instead of regenerating it.
+	void setRetainedChunkBudget(size_t bytes) { m_retainedChunkBudget = bytes; m_areDrawnChunksStale = true; }
+
+	// Whether a coarse version of missing terrain is loaded ahead of the full one. The whole view then
+	// fills in quickly after startup or a teleport and is refined from there. On by default.
+	void setProgressiveLoading(bool enabled) { m_isProgressiveLoading = enabled; m_isLodSelectionStale = true; }
+
+	// Builds the chunk's density and mesh on the job system, independently of what is streamed in for 
+	// rendering. Call and await on the main thread, see ChunkRequest.
+	ChunkRequest requestChunk(const glm::i32vec3& position, uint32_t lodLevel);
+
+	// Finds the resident chunk at a node coordinate of a LOD level in constant time, false if it isn't
+	// loaded. Safe to call from any thread without locking. The chunk can be unloaded right after, check
+	// the handle with Chunks::has on the main thread before using it there.
+	bool findChunk(const glm::i32vec3& position, uint32_t lodLevel, ChunkHandle& outHandle) const;
+
 private:
-	void _workerThreadEP(size_t workerIndex, size_t workerCount);
+	struct ChunkTask;
+	struct ChunkRequestJob;
+
+	static void chunkStageJobEP(void* data);
+	static void chunkRequestJobEP(void* data);
+	void _startChunkRequests();
+	void _cancelChunkRequest(ChunkRequestJob* job);
+	void _pumpChunkPipeline();
+	bool _hasChunkStageWork(ChunkStage stage);
+	ChunkTask* _claimChunkTask();
+	ChunkTask* _claimChunkTask(const glm::i32vec3& position, uint32_t lodLevel);
+	ChunkTask* _takeChunkTask(ChunkStage stage);
+	void _runChunkStage(ChunkStage stage);
+	void _processChunkTask(ChunkStage stage, ChunkTask* task);
+	void _forwardChunkTask(ChunkStage stage, ChunkTask* task);
+	void _finishChunkTask(ChunkTask* task);
+	void _dropChunkTask(ChunkStage stage, ChunkTask* task);
+	void _loadChunkInParallel(const glm::i32vec3& cameraPosChunkSpace);
+	bool _isUploadBacklogFull() const;
+	void _uploadChunks();
+	bool _hasChunksAround(const glm::i32vec3& position) const;
+	void _recycleChunkCells();
+	float _getStreamingRadius() const;
+	void _updateColumnBounds(const glm::i32vec3& regionMin, float radius);
+	bool _isChunkCulled(const glm::i32vec3& position) const;
+	ChunkPriorityView _getChunkPriorityView() const;
+	float _getChunkPriority(const glm::i32vec3& position, uint32_t lodLevel, const ChunkPriorityView& view) const;
+	void _selectChunkLods(const ChunkPriorityView& priorityView);
+	uint32_t _findLodNode(const glm::i32vec3& position, uint32_t lodLevel) const;
+	uint32_t _findLodLeaf(const glm::i32vec3& position) const;
+	void _updateDrawnChunks();
+	void _evictChunk(ChunkHandle handle);
+	void _removeChunk(ChunkHandle handle);
+	size_t _countVisibleMissingChunks() const;
 	void _createSamplers();
 	void _createChunkPipeline();
 	void _createChunkAllocator();
 	void _createUniformBuffer();
-	void _createStagingBuffer();
+	void _createStagingBuffer(size_t i, VkDeviceSize size);
+	void _destroyStagingBuffer(size_t i);
+	void _growStagingBuffer(size_t usedSize, VkDeviceSize minSize);
 
 	void _createResolvePipeline();
 
@@ -67,14 +216,15 @@ private:
 	void _debugDrawChunkAllocator();
 
 
-	std::vector<std::thread> m_threads;
+	std::atomic<bool> m_isRunning;
 
-	bool m_isRunning;
+	jobs::Counter m_chunkJobCounter;
 
 	enum class WorkItemType
 	{
 		LoadChunk,
 		ChunkLoaded,
+		ChunkRequestDone,
 	};
 
 	struct WorkItemData_ChunkLoaded
@@ -85,6 +235,20 @@ private:
 		VisualChunk visualChunk;
 		glm::i32vec3 position;
 		uint8_t lodLevel;
+		// The grid cell as the worker left it, the chunk is uploaded only if it is still the same.
+		ChunkCell cell;
+	};
+
+	struct ChunkRequestJob
+	{
+		World* world;
+		std::shared_ptr<ChunkRequestState> state;
+	};
+
+	struct WorkItemData_ChunkRequestDone
+	{
+		// Owned by the work item.
+		ChunkRequestJob* job;
 	};
 
 	struct WorkItem
@@ -93,10 +257,70 @@ private:
 		//union 
 		//{
 			WorkItemData_ChunkLoaded chunkLoaded;
+			WorkItemData_ChunkRequestDone chunkRequestDone;
 		//} data;
 	};
 
+	// Every job thread's own channel to the main thread, by jobs::currentThreadIndex. The shared queue takes 
+	// what doesn't fit and work from other threads, it alone has room for every reservation.
+	std::vector<std::unique_ptr<spsc_bounded_queue<WorkItem>>> m_threadWorkQueues;
 	mpmc_bounded_queue<WorkItem> m_mainThreadWorkQueue;
+	// Queue slots promised to chunks and requests being built, released as the main thread dequeues.
+	std::atomic<uint32_t> m_reservedMainThreadWork;
+	// Requests waiting for a chunk job slot, started as the budget allows. Main thread only.
+	std::vector<ChunkRequestJob*> m_queuedChunkRequests;
+
+	void _pushMainThreadWork(const WorkItem& work);
+	size_t _popMainThreadWork(WorkItem* work, size_t maxCount);
+	size_t _countMainThreadWork() const;
+
+	// A generated chunk waiting for room in the staging buffer, main thread only.
+	struct PendingChunkUpload
+	{
+		float priority;
+		WorkItemData_ChunkLoaded chunk;
+	};
+
+	void _commitChunkUpload(WorkItemData_ChunkLoaded& chunk, size_t stagingBufferOffset);
+	void _dropChunkUpload(WorkItemData_ChunkLoaded& chunk);
+
+	// A chunk on its way through the generation stages.
+	struct ChunkTask
+	{
+		// The grid cell while the chunk is generated, it is abandoned once the cell has moved on.
+		ChunkCell cell;
+		std::unique_ptr<float[]> terrainSamples;
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> normals;
+		WorkItemData_ChunkLoaded result;
+	};
+
+	struct ChunkPipelineStage
+	{
+		static constexpr size_t QueueCapacity = 16;
+
+		ChunkPipelineStage()
+			: input(QueueCapacity)
+			, reservedCount(0)
+			, activeJobs(0)
+			, maxActiveJobs(1)
+			, world(nullptr)
+			, stage(ChunkStage_Sample)
+		{
+		}
+
+		// Tasks waiting for this stage. The sample stage pops the scheduler instead.
+		mpmc_bounded_queue<ChunkTask*> input;
+		// Input slots taken by the previous stage, it stalls once they run out.
+		std::atomic<uint32_t> reservedCount;
+		std::atomic<uint32_t> activeJobs;
+		uint32_t maxActiveJobs;
+
+		World* world;
+		ChunkStage stage;
+	};
+
+	ChunkPipelineStage m_chunkStages[ChunkStage_Count];
 
 	Camera m_camera;
 
@@ -104,8 +328,71 @@ private:
 
 	Chunks m_chunks;
 
-	std::shared_mutex m_gridMutex;
 	ChunkGrid m_chunkGrid;
+	ChunkScheduler m_chunkScheduler;
+	std::vector<ChunkScheduler::Request> m_chunkRequests;
+	// Chunks that came into each level's region with the last move, their cells are the only ones it touched.
+	std::vector<glm::i32vec3> m_enteringChunks[ChunkMaxLOD + 1];
+
+	ChunkLodSelector m_lodSelector;
+	ChunkLodBudget m_lodBudget;
+	bool m_isLodSelectionStale;
+
+	// Per node of the selection, rebuilt whenever a chunk is added or the selection changes.
+	struct LodNodeState
+	{
+		// Ready itself if it is a leaf, or through its children.
+		bool isCovered;
+		// Something above it is drawn in its place.
+		bool isHidden;
+		bool isDrawn;
+		// Drawn itself or through its children, none of it is missing on screen.
+		bool isShown;
+	};
+
+	std::vector<LodNodeState> m_lodNodeStates;
+	// Nodes of the previous selection that were still being built, main thread scratch.
+	std::vector<ChunkLodNode> m_inFlightLodNodes;
+	bool m_areDrawnChunksStale;
+	// Counts the drawn chunk updates, see Chunks::lastWanted.
+	uint32_t m_drawnChunksUpdateIndex;
+
+	// Resident chunks nothing wants any more, main thread scratch, and the bytes they may take up.
+	std::vector<ChunkHandle> m_retainedChunks;
+	size_t m_retainedChunkBudget;
+
+	bool m_isProgressiveLoading;
+	// Whether every root was shown at the last update of the drawn chunks, and for how many seconds the
+	// view has had holes in it since it last was.
+	bool m_isHorizonComplete;
+	float m_horizonLoadTime;
+
+	// Vertices and chunk count of the resident chunks per LOD level, what the selection budgets with.
+	size_t m_lodVertexCounts[ChunkMaxLOD + 1];
+	size_t m_lodChunkCounts[ChunkMaxLOD + 1];
+
+	// Requests whose cell was taken by another claim of the same generation, requests whose cell was
+	// recycled or cancelled since, and chunks abandoned because their cell was handed to another chunk
+	// while they were built. Counted since the last frame.
+	std::atomic<uint32_t> m_chunkClaimConflicts;
+	std::atomic<uint32_t> m_staleChunkRequests;
+	std::atomic<uint32_t> m_staleChunkDrops;
+
+	float m_fogStart;
+	float m_fogEnd;
+
+	float m_prefetchLookAhead;
+	float m_chunkPriorityRefreshTimer;
+
+	std::vector<PendingChunkUpload> m_pendingUploads;
+	// Staging bytes of the chunks finished by workers and not uploaded yet, including those still in the work queue.
+	std::atomic<size_t> m_pendingUploadBytes;
+	float m_uploadTimeBudget;
+
+	// Chunk jobs running across all stages, and how many the throttle allows.
+	std::atomic<uint32_t> m_activeChunkJobs;
+	std::atomic<uint32_t> m_chunkJobBudget;
+	GenerationThrottle m_generationThrottle;
 
 	VkDeviceSize m_uniformBufferSize{ 64u * 1024u };
 	VkBuffer m_uniformBuffer;
@@ -121,7 +408,9 @@ private:
 		VkDeviceSize size;
 	};
 
+	// What each frame's staging buffer starts out with, and what it has grown to for oversized chunks.
 	VkDeviceSize m_chunkStagingBufferSize;
+	VkDeviceSize m_chunkStagingBufferSizes[5];
 	VkBuffer m_chunkStagingBuffer[5];
 	VkDeviceMemory m_chunkStagingBufferMemory[5];
 	void* m_chunkStagingBufferData[5];